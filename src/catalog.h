@@ -0,0 +1,34 @@
+#pragma once
+
+/* every drink, in the order they're shown - DRINK(id, header, detail, paint) where paint is the sequence of
+   layers that draws it, bottom up. Everything that depends on which drink is which (the entry numbers, the text
+   tables and the paint dispatch) is generated from this list, so adding a drink means adding a line here. The
+   detail text is read from here by tools/pack_strings.py at build time, and packed into a resource, and the
+   names by tools/pack_index.py into the index for jumping to a letter. tools/dither_drinks.py renders each
+   paint, for black & white screens to blit */
+#define DRINK_CATALOG(DRINK) \
+	DRINK(ESPRESSO, "Espresso", \
+			"Espresso is made by forcing hot water through finely ground coffee at high pressure", \
+			draw_espresso_shot(ctx);) \
+	DRINK(AMERICANO, "Americano", \
+			"An espresso shot topped up with hot water (black americano) and maybe some milk (white americano)", \
+			draw_water_to_top(ctx); draw_espresso_shot(ctx);) \
+	DRINK(CAPPUCCINO, "Cappuccino", \
+			"An espresso shot topped up with equal amounts of steamed milk and milk froth", \
+			draw_foam_to_top(ctx); draw_milk_to_mid(ctx); draw_espresso_shot(ctx);) \
+	DRINK(LATTE, "Latte", \
+			"An espresso shot topped with steam milk - similar to cappuccino but without the froth", \
+			draw_foam_to_top(ctx); draw_milk_to_high(ctx); draw_espresso_shot(ctx);) \
+	DRINK(MACCHIATO, "Macchiato", \
+			"An espresso shot 'stained' with a little steamed or frothed milk", \
+			draw_foam_to_very_low(ctx); draw_espresso_shot(ctx);) \
+	DRINK(RISTRETTO, "Ristretto", \
+			"A 'short' shot of espresso, giving a bolder flavour with less bitterness", \
+			draw_espresso_shot(ctx);)
+
+/* the entry numbers - DRINK_ESPRESSO is 0 and so on, with ENTRIES the number of drinks */
+#define DRINK_ENUM(id, header, detail, ...) DRINK_##id,
+enum {
+	DRINK_CATALOG(DRINK_ENUM)
+	ENTRIES
+};
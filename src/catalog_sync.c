@@ -0,0 +1,300 @@
+#include <pebble.h>
+#include "catalog_sync.h"
+#include "name_index.h"
+#include "draw_layers.h"
+
+/********************************************/
+/*************** DECLARATIONS ***************/
+/********************************************/
+
+/* message keys, matching appKeys in appinfo.json */
+#define KEY_SYNC_BEGIN 0
+#define KEY_SYNC_CHUNK 1
+#define KEY_SYNC_END 2
+#define KEY_SYNC_STORED 3
+
+/* the inbox only has to hold one chunk - tools/js/catalog_sync_standin.js sends them no bigger than 128 bytes */
+#define SYNC_INBOX_SIZE 160
+#define SYNC_OUTBOX_SIZE 32
+
+/* persistent storage - the count, the first drink per letter, then one key per drink holding it as it was sent */
+#define PERSIST_KEY_SYNC_COUNT 20
+#define PERSIST_KEY_SYNC_INDEX 21
+#define PERSIST_KEY_SYNC_DRINK 30
+
+/* a record is three fields, each a length byte then that many bytes */
+#define RECORD_FIELDS 3
+#define NO_DRINK 0xFF
+
+/* the synced drinks held in memory - just what's needed to show & paint them, the detail text stays in storage */
+static int syncedCount = 0;
+static char syncedNames[MAX_SYNCED_DRINKS][SYNC_NAME_MAX + 1];
+static uint8_t syncedLayers[MAX_SYNCED_DRINKS][SYNC_MAX_LAYERS];
+static uint8_t syncedNumLayers[MAX_SYNCED_DRINKS];
+static uint8_t syncedFirst[NAME_INDEX_BUCKETS];
+
+/* the record being parsed - chunks can end anywhere, so this is all the state carried from one to the next.
+   Records too big to store are still counted through, but not kept */
+static struct {
+	uint8_t record[PERSIST_DATA_MAX_LENGTH];
+	int length;
+	int field;
+	int fieldLeft;
+} parser;
+
+/* how the sync in progress is going */
+static CatalogSyncHandler syncStartedHandler;
+static CatalogSyncHandler syncEndedHandler;
+static bool syncing = false;
+static int syncBytes = 0;
+static int syncDropped = 0;
+#if DRAW_TIMING
+static int syncPeakHeap = 0;
+static time_t syncStartSeconds;
+static uint16_t syncStartMillis;
+#endif
+
+/********************************************/
+/***************** RECORDS ******************/
+/********************************************/
+
+/* check a record and pull out the parts kept in memory - false if it's malformed */
+static bool read_record(const uint8_t *record, int length, char *name, uint8_t *layers, uint8_t *numLayers) {
+	int nameLength = record[0];
+	if (nameLength == 0 || nameLength > SYNC_NAME_MAX || 1 + nameLength >= length) {
+		return false;
+	}
+	int layerCount = 1 + nameLength + 1 + record[1 + nameLength];
+	if (layerCount >= length || record[layerCount] > SYNC_MAX_LAYERS || layerCount + 1 + record[layerCount] != length) {
+		return false;
+	}
+	for (int i = 0; i < record[layerCount]; i++) {
+		if (record[layerCount + 1 + i] >= SYNC_LAYER_COUNT) {
+			return false;
+		}
+	}
+
+	memcpy(name, &record[1], nameLength);
+	name[nameLength] = '\0';
+	*numLayers = record[layerCount];
+	memcpy(layers, &record[layerCount + 1], *numLayers);
+	return true;
+}
+
+/* put a newly stored drink into the per-letter index if it comes first in its letter */
+static void index_drink(int n) {
+	int bucket = name_index_bucket(syncedNames[n][0]);
+	if (syncedFirst[bucket] == NO_DRINK || name_index_compare(syncedNames[n], syncedNames[syncedFirst[bucket]]) < 0) {
+		syncedFirst[bucket] = n;
+		persist_write_data(PERSIST_KEY_SYNC_INDEX, syncedFirst, sizeof(syncedFirst));
+	}
+}
+
+/* a whole record has arrived - keep it if it's good and there's room, straight into storage */
+static void finish_record() {
+	int n = syncedCount;
+	if (parser.length > PERSIST_DATA_MAX_LENGTH || n >= MAX_SYNCED_DRINKS
+			|| !read_record(parser.record, parser.length, syncedNames[n], syncedLayers[n], &syncedNumLayers[n])) {
+		syncDropped++;
+		return;
+	}
+
+	if (persist_write_data(PERSIST_KEY_SYNC_DRINK + n, parser.record, parser.length) != parser.length) {
+		syncDropped++;
+		return;
+	}
+	syncedCount++;
+	persist_write_int(PERSIST_KEY_SYNC_COUNT, syncedCount);
+	index_drink(n);
+}
+
+/* take the next byte of the stream - a field's length byte, or one of its bytes */
+static void parse_byte(uint8_t byte) {
+	if (parser.length < PERSIST_DATA_MAX_LENGTH) {
+		parser.record[parser.length] = byte;
+	}
+	parser.length++;
+	parser.fieldLeft = (parser.fieldLeft < 0) ? byte : parser.fieldLeft - 1;
+
+	if (parser.fieldLeft == 0) {
+		parser.fieldLeft = -1;
+		if (++parser.field == RECORD_FIELDS) {
+			finish_record();
+			parser.length = 0;
+			parser.field = 0;
+		}
+	}
+}
+
+/********************************************/
+/****************** SYNC ********************/
+/********************************************/
+
+/* a new catalog is on its way - it replaces the synced drinks there are now */
+static void begin_sync() {
+	if (syncStartedHandler) {
+		syncStartedHandler();
+	}
+	for (int n = 0; n < syncedCount; n++) {
+		persist_delete(PERSIST_KEY_SYNC_DRINK + n);
+	}
+	syncedCount = 0;
+	persist_write_int(PERSIST_KEY_SYNC_COUNT, 0);
+	memset(syncedFirst, NO_DRINK, sizeof(syncedFirst));
+	persist_write_data(PERSIST_KEY_SYNC_INDEX, syncedFirst, sizeof(syncedFirst));
+
+	parser.length = 0;
+	parser.field = 0;
+	parser.fieldLeft = -1;
+	syncing = true;
+	syncBytes = 0;
+	syncDropped = 0;
+#if DRAW_TIMING
+	syncPeakHeap = heap_bytes_used();
+	time_ms(&syncStartSeconds, &syncStartMillis);
+#endif
+}
+
+/* all sent - tell the phone how many were kept */
+static void end_sync() {
+	if (parser.length > 0) {
+		/* the stream stopped part way through a record */
+		syncDropped++;
+	}
+	syncing = false;
+
+#if DRAW_TIMING
+	time_t seconds;
+	uint16_t millis;
+	time_ms(&seconds, &millis);
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "catalog sync: %d drinks stored, %d dropped, %d bytes in %d ms, heap peak %d",
+			syncedCount, syncDropped, syncBytes,
+			(int)((seconds - syncStartSeconds) * 1000 + millis - syncStartMillis), syncPeakHeap);
+#endif
+
+	DictionaryIterator *out;
+	if (app_message_outbox_begin(&out) == APP_MSG_OK) {
+		dict_write_int32(out, KEY_SYNC_STORED, syncedCount);
+		app_message_outbox_send();
+	}
+	if (syncEndedHandler) {
+		syncEndedHandler();
+	}
+}
+
+/* each message is a chunk of the stream, maybe with the start or end marked */
+static void inbox_received(DictionaryIterator *iter, void *context) {
+	if (dict_find(iter, KEY_SYNC_BEGIN)) {
+		begin_sync();
+	}
+
+	Tuple *chunk = dict_find(iter, KEY_SYNC_CHUNK);
+	if (chunk && syncing) {
+		for (int i = 0; i < chunk->length; i++) {
+			parse_byte(chunk->value->data[i]);
+		}
+		syncBytes += chunk->length;
+#if DRAW_TIMING
+		if ((int)heap_bytes_used() > syncPeakHeap) {
+			syncPeakHeap = heap_bytes_used();
+		}
+#endif
+	}
+
+	if (dict_find(iter, KEY_SYNC_END) && syncing) {
+		end_sync();
+	}
+}
+
+static void inbox_dropped(AppMessageResult reason, void *context) {
+	APP_LOG(APP_LOG_LEVEL_WARNING, "catalog sync: message dropped (%d)", (int)reason);
+}
+
+/********************************************/
+/****************** ACCESS ******************/
+/********************************************/
+
+void catalog_sync_init(CatalogSyncHandler started, CatalogSyncHandler ended) {
+	syncStartedHandler = started;
+	syncEndedHandler = ended;
+	memset(syncedFirst, NO_DRINK, sizeof(syncedFirst));
+	if (persist_exists(PERSIST_KEY_SYNC_INDEX)) {
+		persist_read_data(PERSIST_KEY_SYNC_INDEX, syncedFirst, sizeof(syncedFirst));
+	}
+
+	/* only the names & layers are kept in memory - the records are read one at a time through the parser's buffer */
+	int count = persist_exists(PERSIST_KEY_SYNC_COUNT) ? persist_read_int(PERSIST_KEY_SYNC_COUNT) : 0;
+	for (int n = 0; n < count && n < MAX_SYNCED_DRINKS; n++) {
+		int length = persist_read_data(PERSIST_KEY_SYNC_DRINK + n, parser.record, sizeof(parser.record));
+		if (length <= 0 || !read_record(parser.record, length, syncedNames[n], syncedLayers[n], &syncedNumLayers[n])) {
+			break;
+		}
+		syncedCount = n + 1;
+	}
+
+	app_message_register_inbox_received(inbox_received);
+	app_message_register_inbox_dropped(inbox_dropped);
+	app_message_open(SYNC_INBOX_SIZE, SYNC_OUTBOX_SIZE);
+}
+
+int catalog_sync_count() {
+	return syncedCount;
+}
+
+const char* catalog_sync_name(int n) {
+	return (n >= 0 && n < syncedCount) ? syncedNames[n] : "";
+}
+
+const uint8_t* catalog_sync_layers(int n, int *numLayers) {
+	if (n < 0 || n >= syncedCount) {
+		*numLayers = 0;
+		return NULL;
+	}
+	*numLayers = syncedNumLayers[n];
+	return syncedLayers[n];
+}
+
+/* a copy of the detail, the middle field of a record - NULL if the record's too short for it */
+static char* copy_detail(const uint8_t *record, int length) {
+	if (length <= 0 || 1 + record[0] >= length) {
+		return NULL;
+	}
+	int start = 1 + record[0] + 1;
+	int detailLength = record[start - 1];
+	if (start + detailLength > length) {
+		return NULL;
+	}
+
+	char *detail = malloc(detailLength + 1);
+	if (detail) {
+		memcpy(detail, &record[start], detailLength);
+		detail[detailLength] = '\0';
+	}
+	return detail;
+}
+
+/* the record is read through the parser's buffer rather than one on the stack - unless a sync is part way through
+   a record in it, when a buffer is borrowed from the heap for the read */
+char* catalog_sync_detail(int n) {
+	if (n < 0 || n >= syncedCount) {
+		return NULL;
+	}
+	bool borrowed = parser.length > 0;
+	uint8_t *record = borrowed ? malloc(PERSIST_DATA_MAX_LENGTH) : parser.record;
+	if (!record) {
+		return NULL;
+	}
+
+	char *detail = copy_detail(record, persist_read_data(PERSIST_KEY_SYNC_DRINK + n, record, PERSIST_DATA_MAX_LENGTH));
+	if (borrowed) {
+		free(record);
+	}
+	return detail;
+}
+
+int catalog_sync_first(int bucket) {
+	if (bucket < 0 || bucket >= NAME_INDEX_BUCKETS || syncedFirst[bucket] >= syncedCount) {
+		return -1;
+	}
+	return syncedFirst[bucket];
+}
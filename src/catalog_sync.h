@@ -0,0 +1,38 @@
+#pragma once
+#include <pebble.h>
+
+/* drinks synced from the phone are kept in persistent storage and shown after the built in catalog - storage is
+   small, so only a few are kept. Each is a name, detail text and the layers that paint it, as the phone sends it:
+   uint8 name length, name, uint8 detail length, detail, uint8 number of layers, layers */
+#define MAX_SYNCED_DRINKS 8
+#define SYNC_NAME_MAX 24
+#define SYNC_MAX_LAYERS 6
+
+/* the layers a synced drink can be painted from, in the order the phone numbers them */
+enum {
+	SYNC_LAYER_ESPRESSO_SHOT,
+	SYNC_LAYER_WATER_TO_TOP,
+	SYNC_LAYER_FOAM_TO_TOP,
+	SYNC_LAYER_MILK_TO_MID,
+	SYNC_LAYER_MILK_TO_HIGH,
+	SYNC_LAYER_MILK_TO_LOW,
+	SYNC_LAYER_FOAM_TO_VERY_LOW,
+	SYNC_LAYER_COUNT
+};
+
+/* called when a sync is about to replace the synced drinks (the old ones are still there during the call), and
+   when it's stored all the new ones */
+typedef void (*CatalogSyncHandler)(void);
+
+/* load the synced drinks from storage and start listening for the phone */
+void catalog_sync_init(CatalogSyncHandler started, CatalogSyncHandler ended);
+
+int catalog_sync_count();
+const char* catalog_sync_name(int n);
+const uint8_t* catalog_sync_layers(int n, int *numLayers);
+
+/* read a synced drink's detail text from storage into a new heap buffer the caller frees - NULL if there isn't one */
+char* catalog_sync_detail(int n);
+
+/* the first synced drink, in name order, in a name index bucket - -1 if there are none */
+int catalog_sync_first(int bucket);
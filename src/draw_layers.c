@@ -1,39 +1,209 @@
 #include <pebble.h>
 #include "draw_layers.h"
 #include "gpath_builder.h"
+#include "span_cache.h"
+#include "path_arena.h"
+#include "catalog.h"
+#include "string_table.h"
+#include "catalog_sync.h"
+#include "name_index.h"
 
 /********************************************/
 /*************** DECLARATIONS ***************/
 /********************************************/
 	
-#define ENTRIES 6
+/* no path should come anywhere near this - more points means a recipe mistake, so the path isn't built */
 #define MAX_POINTS 256
+
+/* paths are carved out of chunks this big - enough for all of a set's paths in one or two */
+#define PATH_ARENA_CHUNK 512
 #define CUP_STROKE 3
 #define HANDLE_STROKE 3
 #define LIM_STROKE 6
 #define OUTLINE_STROKE 2
+#define MAX_STROKES 3
+#define MAX_COMMANDS 16
+
+/* the built in drinks, then room for the ones synced from the phone */
+#define MAX_ENTRIES (ENTRIES + MAX_SYNCED_DRINKS)
+
+/* everything kept to save drawing again - stroke spans, display lists, thumbnails, dithered drinks and the cup
+   overlay - shares one budget, and none of it is let into the last HEAP_RESERVE bytes of the heap, which the
+   windows, paths & text need. Capturing pixels takes scratch copies of the box that have to come in one piece,
+   and the free bytes don't say how they're split, so the reserve is generous. Only colour screens capture
+   pixels, so black & white ones need far less */
+#define CACHE_BUDGET PBL_IF_COLOR_ELSE(36 * 1024, 7 * 1024)
+#define HEAP_RESERVE PBL_IF_COLOR_ELSE(20 * 1024, 2 * 1024)
+#define DITHERED_HEADER_SIZE 3
+#define DITHERED_ENTRY_SIZE 6
+
+/* the drawings are designed for the 123 x 133 draw layer of a 144 x 168 screen */
+#define DESIGN_WIDTH 123
+#define DESIGN_HEIGHT 133
+
+/* persistent storage - flattened paths are kept between runs along with a hash of everything that went into
+   them; bump PATH_CACHE_VERSION if the flattening itself changes */
+#define PATH_CACHE_VERSION 4
+#define PERSIST_KEY_PATH_HASH 10
+#define PERSIST_KEY_CUP_PATH 11
+#define PERSIST_KEY_HANDLE_PATH 12
+#define PERSIST_KEY_INTERIOR_PATH 13
+
+/* flattening tolerances, in degrees */
+#define FULL_TOLERANCE 10
+#define THUMBNAIL_TOLERANCE 30
+#define PREVIEW_TOLERANCE 25
+
+#define LEVEL_TOP 35
+#define LEVEL_HIGH 42
+#define LEVEL_MID 55
+#define LEVEL_LOW 65
+#define LEVEL_SHOT 75
 	
 #define CUP_COLOUR GColorWhite
 #define COFFEE_COLOUR GColorBlack
-#define LIM_COLOUR GColorDarkGray
-#define OUTLINE_COLOUR GColorDarkGray
-#define FOAM_COLOUR GColorPastelYellow
-#define WATER_COLOUR GColorBabyBlueEyes
-#define MILK_COLOUR GColorPastelYellow
+#define LIM_COLOUR COLOR_FALLBACK(GColorDarkGray, GColorBlack)
+#define OUTLINE_COLOUR COLOR_FALLBACK(GColorDarkGray, GColorBlack)
+#define FOAM_COLOUR COLOR_FALLBACK(GColorPastelYellow, GColorWhite)
+#define WATER_COLOUR COLOR_FALLBACK(GColorBabyBlueEyes, GColorWhite)
+#define MILK_COLOUR COLOR_FALLBACK(GColorPastelYellow, GColorWhite)
 
-char *headerText[ENTRIES];
-char *detailText[ENTRIES];
-bool headersPopulated = false;
-bool detailsPopulated = false;
+/* the headers straight from the catalog - the detail text is packed into a resource at build time, and only
+   the one being shown is decoded */
+#define DRINK_HEADER(id, header, detail, ...) header,
+const char *const headerText[ENTRIES] = { DRINK_CATALOG(DRINK_HEADER) };
+char *detailText = NULL;
 
-/* empty function declarations so we can put them below for improved legibility */
-void draw_espresso(GContext *ctx);
-void draw_americano(GContext *ctx);
-void draw_cappuccino(GContext *ctx);
-void draw_latte(GContext *ctx);
-void draw_macchiato(GContext *ctx);
-void draw_ristretto(GContext *ctx);
+/* recorded stroke pixels per drink, in the order the strokes are painted, and when each drink was last used */
+SpanSet *strokeSpans[MAX_ENTRIES][MAX_STROKES];
+size_t strokeSpanBytes = 0;
+int strokeSteps[MAX_ENTRIES];
+bool strokeStepsKnown[MAX_ENTRIES];
+uint32_t lastUsed[MAX_ENTRIES];
+uint32_t useClock = 0;
+
+/* how often a stroke came from the cache - prefetch paints aren't counted */
+int cacheHits = 0;
+int cacheMisses = 0;
+bool prefetching = false;
+
+/* the drink currently being painted - where its layer is on screen, the part of it that can be seen (layer
+   coordinates) and how many strokes so far */
+int paintItem;
+int paintStep;
+GPoint paintOrigin;
+GRect paintVisible;
+bool paintCulled;
+
+/* components drawn & skipped because they couldn't be seen */
+int drawnCount = 0;
+int culledCount = 0;
+
+/* paths for drawing at one size - the transform from design coordinates (and flattening tolerance) is baked in
+   as each path is built the first time it's needed, and they're kept for every later frame. They all come from
+   the set's arena, and are freed together with it */
+typedef struct {
+	GPathTransform transform;
+	int32_t tolerance;
+	PathArena *arena;
+	GPath *cupPath;
+	GPath *handlePath;
+	/* the inside of the cup, flattened once - every liquid is this profile cut off at its level */
+	GPath *interiorPath;
+	GPath liquidPath;
+	int interiorBottom;
+	int interiorLeft;
+	int interiorRight;
+} PathSet;
+
+/* recipes for the paths, in design coordinates - curves are (to, control 1, control 2). Bowls are top left,
+   top right, then curves down to the bottom and back up to top left */
+const GPoint cupRecipe[] = { {5,20}, {115,20}, {60,100}, {115,60}, {90,100}, {5,20}, {30,100}, {5,60} };
+const GPoint interiorRecipe[] = { {8,35}, {110,35}, {60,100}, {110,70}, {80,100}, {8,35}, {40,100}, {8,70} };
+
+/* the handle is a start point then two curves */
+const GPoint handleRecipe[] = { {114,30}, {122,38}, {120,25}, {123,25}, {111,45}, {120,50}, {110,47} };
+
+/* how many paths were restored from persistent storage rather than flattened */
+int pathsRestored = 0;
+
+/* full size for the draw layers, and small & coarse for thumbnails - paths points at the set being drawn */
+PathSet fullSize = { .transform = GPathTransformIdentity, .tolerance = FULL_TOLERANCE };
+PathSet thumbnailSize = { .transform = GPathTransformIdentity, .tolerance = THUMBNAIL_TOLERANCE };
+PathSet *paths = &fullSize;
+
+/* while drawings are moving they're painted at preview quality - full size, but from coarser paths, without
+   liquid outlines and with sparser foam */
+PathSet previewSize = { .transform = GPathTransformIdentity, .tolerance = PREVIEW_TOLERANCE };
+GraphicsQuality quality = QUALITY_FULL;
+
+/* the cup & handle are the same for every drink, so are drawn once and kept as a bitmap to overlay */
+GBitmap *cupOverlay;
+GRect cupBox;
+size_t overlayBytes = 0;
+
+/* thumbnails are rendered once and kept as bitmaps - paintOffset moves a thumbnail into its cell as it's drawn */
+GBitmap *thumbnailBitmaps[MAX_ENTRIES];
+uint32_t thumbnailUsed[MAX_ENTRIES];
+size_t thumbnailBytes = 0;
+GPoint paintOffset;
+
+/* black & white screens blit each built in drink dithered at build time (by tools/dither_drinks.py) instead of
+   drawing it - loaded the first time it's needed, and kept like the thumbnails */
+#ifndef PBL_COLOR
+GBitmap *ditheredBitmaps[ENTRIES];
+GRect ditheredBoxes[ENTRIES];
+uint32_t ditheredUsed[ENTRIES];
+size_t ditheredBytes = 0;
+#endif
+
+/* display lists - the commands each drink's full size paint comes down to, once its paths are built and its
+   levels & foam rows scaled, recorded the first time it's painted and replayed after that */
+enum {
+	DL_LIQUID,
+	DL_CIRCLES,
+	DL_STROKE_COLOUR,
+};
+
+typedef struct {
+	uint8_t op;
+	GColor8 color;
+	uint8_t step;
+	uint8_t radius;
+	int16_t y;
+	int16_t from;
+	int16_t to;
+} DisplayCommand;
+
+typedef struct {
+	uint8_t num_commands;
+	DisplayCommand commands[];
+} DisplayList;
+
+DisplayList *displayLists[MAX_ENTRIES];
+size_t listBytes = 0;
+DisplayCommand recording[MAX_COMMANDS];
+int recordingCount = -1;
+GColor8 recordedStroke;
+bool recordedStrokeKnown;
+int listsRecorded = 0;
+int listReplays = 0;
+int commandsRecorded = 0;
+int commandsReplayed = 0;
+int replayMillis = 0;
 
+/* full size paints of the built in drinks, by whether they were blitted or drawn, with DRAW_TIMING */
+int ditheredBlits = 0;
+int ditheredMillis = 0;
+int drawnPaints = 0;
+int drawnMillis = 0;
+
+/* the drink being poured (if any), and how far through the pour we are */
+bool poured[MAX_ENTRIES];
+int pourItem = -1;
+int pourProgress;
+
+/* empty function declarations so we can put them below for improved legibility */
 void draw_cup(GContext *ctx);
 void draw_handle(GContext *ctx);
 void draw_espresso_shot(GContext *ctx);
@@ -44,54 +214,60 @@ void draw_milk_to_high(GContext *ctx);
 void draw_milk_to_low(GContext *ctx);
 void draw_foam_to_very_low(GContext *ctx);
 
-/********************************************/
-/**** HELPER METHODS TO POPULATE ARRAYS *****/
-/********************************************/
-
-/* populates the headerText array */
-void setup_header_text_array() {
-	headerText[0] = "Espresso";
-	headerText[1] = "Americano";
-	headerText[2] = "Cappuccino";
-	headerText[3] = "Latte";
-	headerText[4] = "Macchiato";
-	headerText[5] = "Ristretto";
-}
-
-/* populates the detailText array */
-void setup_detail_text_array() {
-	detailText[0] = "Espresso is made by forcing hot water through finely ground coffee at high pressure";
-	detailText[1] = "An espresso shot topped up with hot water (black americano) and maybe some milk (white americano)";
-	detailText[2] = "An espresso shot topped up with equal amounts of steamed milk and milk froth";
-	detailText[3] = "An espresso shot topped with steam milk - similar to cappuccino but without the froth";
-	detailText[4] = "An espresso shot 'stained' with a little steamed or frothed milk";
-	detailText[5] = "A 'short' shot of espresso, giving a bolder flavour with less bitterness";
-}
+typedef void (*PathRecipe)(GPathBuilder *builder, const GPoint *points);
+GPath* get_path(GPath **slot, uint32_t key, PathRecipe recipe, const GPoint *points);
+void add_bowl(GPathBuilder *builder, const GPoint *points);
+void add_handle(GPathBuilder *builder, const GPoint *points);
+GPath* build_path(PathRecipe recipe, const GPoint *points);
+void free_path_set(PathSet *set);
+PathArena* path_set_arena();
+bool free_thumbnail(int i);
+bool free_display_list(int i);
+bool make_room(size_t bytes);
+void draw_cup_and_handle(GContext *ctx);
+void paint_liquid(GContext *ctx, int level, GColor color);
+void paint_circles(GContext *ctx, int y, int from, int to, int step, int radius);
+void replay_display_list(DisplayList *list, GContext *ctx);
+void set_stroke_colour(GContext *ctx, GColor color);
+void paint_synced_drink(GContext *ctx, int n);
+bool draw_dithered(int i, GContext *ctx);
+void free_dithered_drinks();
+#ifndef PBL_COLOR
+bool free_dithered(int i);
+#endif
 
 /********************************************/
 /***** METHODS TO RETURN REQUESTED TEXT *****/
 /********************************************/
 
-/* return the requested entry from headerText array */
-char* header_text(int i) {
-	/* check whether we've populated the array, if not then do so */
-	if(!headersPopulated) {
-		setup_header_text_array();
-		headersPopulated = true;
-	}
-	/* return the relevant header */
-	return headerText[i];
+/* return the requested entry from headerText array, or the name of a synced drink */
+const char* header_text(int i) {
+	return (i < ENTRIES) ? headerText[i] : catalog_sync_name(i - ENTRIES);
 }
 
-/* return the requested entry from detailText array */
-char* detail_text(int i) {
-	/* check whether we've populated the array, if not then do so */
-	if(!detailsPopulated) {
-		setup_detail_text_array();
-		detailsPopulated = true;
-	}
-	/* return the relevant header */
-	return detailText[i];
+/* decode the requested detail text - it's kept until the next call or release_detail_text */
+const char* detail_text(int i) {
+	release_detail_text();
+	
+#if DRAW_TIMING
+	time_t seconds, startSeconds;
+	uint16_t millis, startMillis;
+	time_ms(&startSeconds, &startMillis);
+#endif
+	detailText = (i < ENTRIES) ? string_table_decode(RESOURCE_ID_DETAIL_TEXT, i) : catalog_sync_detail(i - ENTRIES);
+#if DRAW_TIMING
+	time_ms(&seconds, &millis);
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "detail text %d decoded in %d ms", i,
+			(int)((seconds - startSeconds) * 1000 + millis - startMillis));
+#endif
+	
+	return detailText ? detailText : "";
+}
+
+/* free the decoded detail text once it's no longer shown */
+void release_detail_text() {
+	free(detailText);
+	detailText = NULL;
 }
 
 /********************************************/
@@ -100,13 +276,13 @@ char* detail_text(int i) {
 
 /* get the next entry down, cycling up to end if we're at start */
 int next_down(int current) {
-	int i = (current == (ENTRIES-1)) ? 0 : current + 1;
+	int i = (current == (entry_count()-1)) ? 0 : current + 1;
 	return i;
 }
 
 /* get the next entry up, cycling down to start if we're at end */
 int next_up(int current) {
-	int i = (current == 0) ? ENTRIES - 1 : current - 1;
+	int i = (current == 0) ? entry_count() - 1 : current - 1;
 	return i;
 }
 
@@ -114,206 +290,1060 @@ int next_up(int current) {
 /***** IMAGE DRAWING - MAIN SWITCH CALL *****/
 /********************************************/
 
-/* main image switcher with a casecading if/else statement */
-void draw_graphics_image(int i, GContext *ctx) {
-	if (i >= ENTRIES) {
+/* main image switcher - one case per drink in the catalog, painting its layers in order */
+#define DRINK_PAINT(id, header, detail, ...) case DRINK_##id: __VA_ARGS__ break;
+void draw_graphics_image(int i, GContext *ctx, GPoint origin, GRect visible) {
+	/* note which drink we're painting so its strokes can be cached, and what can be seen */
+	paintItem = i;
+	paintStep = 0;
+	paintOrigin = origin;
+	paintVisible = visible;
+	paintCulled = false;
+	
+	if (i >= entry_count()) {
+		return;
+	}
+	lastUsed[i] = ++useClock;
+	
+#if DRAW_TIMING
+	/* the paints a blit can stand in for are timed, blitted or drawn */
+	bool timed = i < ENTRIES && i != pourItem && paths == &fullSize;
+	time_t paintSeconds, paintEndSeconds;
+	uint16_t paintMillis, paintEndMillis;
+	time_ms(&paintSeconds, &paintMillis);
+#endif
+	/* on black & white screens a drink dithered at build time is a single blit, with nothing to record */
+	if (draw_dithered(i, ctx)) {
+#if DRAW_TIMING
+		time_ms(&paintEndSeconds, &paintEndMillis);
+		ditheredBlits++;
+		ditheredMillis += (paintEndSeconds - paintSeconds) * 1000 + paintEndMillis - paintMillis;
+#endif
 		return;
-	} else if (i == 0) {
-		draw_espresso(ctx);
-	} else if (i == 1) {
-		draw_americano(ctx);
-	} else if (i == 2) {
-		draw_cappuccino(ctx);
-	} else if (i == 3) {
-		draw_latte(ctx);
-	} else if (i == 4) {
-		draw_macchiato(ctx);
-	} else if (i == 5) {
-		draw_ristretto(ctx);
 	}
+	/* previews use the coarser paths - unless the drink already has a display list, as replaying that at full
+	   size, with its strokes from the span cache, is cheaper than working the preview out */
+	if (quality == QUALITY_PREVIEW && paths == &fullSize && !(displayLists[i] && i != pourItem)) {
+		paths = &previewSize;
+	}
+	
+	/* replay the drink's display list if it has one - full size only, and never while it's pouring, as the
+	   levels change every frame */
+	bool listed = paths == &fullSize && i != pourItem;
+	if (listed && displayLists[i]) {
+#if DRAW_TIMING
+		time_t seconds, startSeconds;
+		uint16_t millis, startMillis;
+		time_ms(&startSeconds, &startMillis);
+#endif
+		replay_display_list(displayLists[i], ctx);
+#if DRAW_TIMING
+		time_ms(&seconds, &millis);
+		replayMillis += (seconds - startSeconds) * 1000 + millis - startMillis;
+#endif
+		listReplays++;
+		commandsReplayed += displayLists[i]->num_commands;
+	} else {
+		/* the stroke colour is whatever the last paint left it, so the first one set is always recorded */
+		recordingCount = listed ? 0 : -1;
+		recordedStrokeKnown = false;
+		switch (i) {
+			DRINK_CATALOG(DRINK_PAINT)
+			default: paint_synced_drink(ctx, i - ENTRIES); break;
+		}
+		if (recordingCount >= 0) {
+			size_t size = sizeof(DisplayList) + recordingCount * sizeof(DisplayCommand);
+			displayLists[i] = make_room(size) ? malloc(size) : NULL;
+			if (displayLists[i]) {
+				displayLists[i]->num_commands = recordingCount;
+				memcpy(displayLists[i]->commands, recording, recordingCount * sizeof(DisplayCommand));
+				listBytes += size;
+				listsRecorded++;
+				commandsRecorded += recordingCount;
+			}
+		}
+		recordingCount = -1;
+	}
+	
+	/* remember how many strokes the drink has, so we can tell when they're all cached */
+	strokeSteps[i] = paintStep;
+	strokeStepsKnown[i] = true;
+	if (paths == &previewSize) {
+		paths = &fullSize;
+	}
+#if DRAW_TIMING
+	if (timed) {
+		time_ms(&paintEndSeconds, &paintEndMillis);
+		drawnPaints++;
+		drawnMillis += (paintEndSeconds - paintSeconds) * 1000 + paintEndMillis - paintMillis;
+	}
+#endif
+}
+
+/* preview quality for drawings on the move, full quality once they've settled */
+void set_graphics_quality(GraphicsQuality level) {
+	quality = level;
+}
+
+/* true if every stroke in a drink has been recorded */
+bool graphics_image_cached(int i) {
+#ifndef PBL_COLOR
+	if (i >= 0 && i < ENTRIES && ditheredBitmaps[i]) {
+		return true;
+	}
+#endif
+	if (i < 0 || i >= entry_count() || !strokeStepsKnown[i]) {
+		return false;
+	}
+	for (int j = 0; j < strokeSteps[i] && j < MAX_STROKES; j++) {
+		if (!strokeSpans[i][j]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* paint a drink we'll need soon into the area of the layer about to be painted, so its strokes are recorded
+   before it's first shown - the area is cleared to the background either side, and whatever the layer
+   paints next covers it; returns false if there was nothing to do */
+bool prefetch_graphics_image(int i, GContext *ctx, GPoint origin, GRect bounds, GColor background) {
+	if (i < 0 || i >= entry_count() || graphics_image_cached(i) || i == pourItem) {
+		return false;
+	}
+	
+	prefetching = true;
+	graphics_context_set_fill_color(ctx, background);
+	graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+	draw_graphics_image(i, ctx, origin, bounds);
+	graphics_context_set_fill_color(ctx, background);
+	graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+	prefetching = false;
+	return true;
+}
+
+/* true if any part of box (layer coordinates) can be seen - counts components drawn & culled, apart from prefetches
+   and thumbnails */
+bool component_visible(GRect box) {
+	bool visible = box.origin.y < paintVisible.origin.y + paintVisible.size.h
+			&& box.origin.y + box.size.h > paintVisible.origin.y
+			&& box.origin.x < paintVisible.origin.x + paintVisible.size.w
+			&& box.origin.x + box.size.w > paintVisible.origin.x;
+	bool counting = !prefetching && paths != &thumbnailSize;
+	drawnCount += (visible && counting) ? 1 : 0;
+	culledCount += (visible || !counting) ? 0 : 1;
+	paintCulled = paintCulled || !visible;
+	return visible;
+}
+
+/* components drawn & culled since the last reset */
+void get_graphics_draw_stats(int *drawn, int *culled, bool reset) {
+	*drawn = drawnCount;
+	*culled = culledCount;
+	if (reset) {
+		drawnCount = 0;
+		culledCount = 0;
+	}
+}
+
+/* display lists recorded & replayed since launch */
+void get_display_list_stats(int *recorded, int *replays, int *recordedCommands, int *replayedCommands,
+		int *millis) {
+	*recorded = listsRecorded;
+	*replays = listReplays;
+	*recordedCommands = commandsRecorded;
+	*replayedCommands = commandsReplayed;
+	*millis = replayMillis;
+}
+
+void get_dithered_stats(int *blits, int *blitsMillis, int *draws, int *drawsMillis) {
+	*blits = ditheredBlits;
+	*blitsMillis = ditheredMillis;
+	*draws = drawnPaints;
+	*drawsMillis = drawnMillis;
+}
+
+/* stroke cache hit & miss counts since launch */
+void get_graphics_cache_stats(int *hits, int *misses) {
+	*hits = cacheHits;
+	*misses = cacheMisses;
 }
 
 /********************************************/
-/**** IMAGES - INDIVIDUAL DRAW FUNCTIONS ****/
+/***** SCREEN SIZES - DESIGN TRANSFORM ******/
 /********************************************/
 
-void draw_espresso(GContext *ctx) {
-	draw_espresso_shot(ctx);
-	draw_cup(ctx);
-	draw_handle(ctx);
+/* the transform that scales & centres the design to fit an area of the given size */
+GPathTransform fit_transform(GSize size) {
+	int32_t scaleX = size.w * GPATH_TRANSFORM_ONE / DESIGN_WIDTH;
+	int32_t scaleY = size.h * GPATH_TRANSFORM_ONE / DESIGN_HEIGHT;
+	int32_t scale = (scaleX < scaleY) ? scaleX : scaleY;
+	return (GPathTransform) {
+		.scale_x = scale,
+		.scale_y = scale,
+		.offset = GPoint((size.w - DESIGN_WIDTH * scale / GPATH_TRANSFORM_ONE) / 2,
+				(size.h - DESIGN_HEIGHT * scale / GPATH_TRANSFORM_ONE) / 2),
+	};
 }
 
-void draw_americano(GContext *ctx) {
-	draw_water_to_top(ctx);
-	draw_espresso_shot(ctx);
-	draw_cup(ctx);
-	draw_handle(ctx);
+/* the number of drinks - the built in ones, then any synced from the phone */
+int entry_count() {
+	return ENTRIES + catalog_sync_count();
 }
 
-void draw_cappuccino(GContext *ctx) {
-	draw_foam_to_top(ctx);
-	draw_milk_to_mid(ctx);
-	draw_espresso_shot(ctx);
-	draw_cup(ctx);
-	draw_handle(ctx);
+/* the most drinks there can be, once the phone has synced as many as there's room for */
+int max_entry_count() {
+	return MAX_ENTRIES;
 }
 
-void draw_latte(GContext *ctx) {
-	draw_foam_to_top(ctx);
-	draw_milk_to_high(ctx);
-	draw_espresso_shot(ctx);
-	draw_cup(ctx);
-	draw_handle(ctx);
+/* the first drink in name order whose name falls in a name index bucket, built in or synced - -1 if none */
+int first_entry_in_bucket(int bucket) {
+	int item = name_index_first(RESOURCE_ID_NAME_INDEX, bucket);
+	int synced = catalog_sync_first(bucket);
+	if (synced >= 0 && (item < 0 || name_index_compare(catalog_sync_name(synced), headerText[item]) < 0)) {
+		item = ENTRIES + synced;
+	}
+	return item;
 }
 
-void draw_macchiato(GContext *ctx) {
-	draw_foam_to_very_low(ctx);
-	draw_espresso_shot(ctx);
-	draw_cup(ctx);
-	draw_handle(ctx);
+bool transform_equal(GPathTransform *a, GPathTransform *b) {
+	return a->scale_x == b->scale_x && a->scale_y == b->scale_y && gpoint_equal(&a->offset, &b->offset);
 }
 
-void draw_ristretto(GContext *ctx) {
-	draw_espresso_shot(ctx);
-	draw_cup(ctx);
-	draw_handle(ctx);
+/* scale & centre the drawings to fit a draw layer of the given size - called before anything is drawn, and
+   every cache is thrown away if it changes so nothing is ever transformed per frame */
+void set_graphics_size(GSize size) {
+	GPathTransform transform = fit_transform(size);
+	if (!transform_equal(&transform, &fullSize.transform)) {
+		destroy_graphics_cache();
+		fullSize.transform = transform;
+		previewSize.transform = transform;
+	}
+}
+
+/* the same for thumbnails */
+void set_thumbnail_size(GSize size) {
+	GPathTransform transform = fit_transform(size);
+	if (!transform_equal(&transform, &thumbnailSize.transform)) {
+		free_path_set(&thumbnailSize);
+		for (int i = 0; i < MAX_ENTRIES; i++) {
+			free_thumbnail(i);
+		}
+		thumbnailSize.transform = transform;
+	}
+}
+
+/* a point in design coordinates, transformed onto the screen */
+GPoint design_point(int x, int y) {
+	return gpath_transform_point(&paths->transform, GPoint(x, y));
+}
+
+/* a length in design coordinates, scaled onto the screen - never less than a pixel */
+int design_length(int length) {
+	int scaled = length * paths->transform.scale_x / GPATH_TRANSFORM_ONE;
+	return (scaled < 1) ? 1 : scaled;
 }
 
 /********************************************/
-/***** IMAGES - DETAILED DRAW FUNCTIONS *****/
+/******* STROKE CACHE - HELPER METHODS ******/
 /********************************************/
 
-/* draw the cup */
-void draw_cup(GContext *ctx) {
-	/* make an epmty GPathBuilder */
-	GPathBuilder *builder = gpath_builder_create(MAX_POINTS);
-	
-	/* build the path */
-	gpath_builder_move_to_point(builder, GPoint(5,20));
-	gpath_builder_line_to_point(builder, GPoint(115,20));
-	gpath_builder_curve_to_point(builder, GPoint(60,100), GPoint(115,60), GPoint(90,100));
-	gpath_builder_curve_to_point(builder, GPoint(5,20), GPoint(30,100), GPoint(5,60));
+/* the area a stroke of the given width can touch - the bounds of the path plus half the width */
+GRect stroke_box(GPath *path, int width) {
+	int minX = path->points[0].x, maxX = minX;
+	int minY = path->points[0].y, maxY = minY;
+	for (uint32_t i = 1; i < path->num_points; i++) {
+		minX = (path->points[i].x < minX) ? path->points[i].x : minX;
+		maxX = (path->points[i].x > maxX) ? path->points[i].x : maxX;
+		minY = (path->points[i].y < minY) ? path->points[i].y : minY;
+		maxY = (path->points[i].y > maxY) ? path->points[i].y : maxY;
+	}
+	int margin = width / 2 + 2;
+	minX = (minX - margin < 0) ? 0 : minX - margin;
+	minY = (minY - margin < 0) ? 0 : minY - margin;
+	return GRect(minX, minY, maxX + margin - minX, maxY + margin - minY);
+}
+
+/* free the recorded strokes for a drink - returns false if it had none */
+bool free_stroke_spans(int i) {
+	bool freed = false;
+	for (int j = 0; j < MAX_STROKES; j++) {
+		if (strokeSpans[i][j]) {
+			strokeSpanBytes -= span_set_size(strokeSpans[i][j]);
+			span_set_destroy(strokeSpans[i][j]);
+			strokeSpans[i][j] = NULL;
+			freed = true;
+		}
+	}
+	return freed;
+}
+
+/* the bytes held by everything sharing CACHE_BUDGET */
+size_t cached_bytes() {
+	size_t bytes = strokeSpanBytes + listBytes + thumbnailBytes + overlayBytes;
+#ifndef PBL_COLOR
+	bytes += ditheredBytes;
+#endif
+	return bytes;
+}
+
+/* free the least recently used thing in any of the caches - a drink's strokes & display list go together, as
+   they're used together. Never anything of the drink being painted; false if there's nothing else to free */
+bool shed_oldest() {
+	enum { SHED_NOTHING, SHED_STROKES, SHED_THUMBNAIL, SHED_DITHERED } shed = SHED_NOTHING;
+	int oldest = -1;
+	uint32_t oldestUsed = 0;
+	for (int i = 0; i < MAX_ENTRIES; i++) {
+		if (i == paintItem) {
+			continue;
+		}
+		bool hasStrokes = displayLists[i] != NULL;
+		for (int j = 0; j < MAX_STROKES; j++) {
+			hasStrokes = hasStrokes || strokeSpans[i][j];
+		}
+		if (hasStrokes && (oldest < 0 || lastUsed[i] < oldestUsed)) {
+			shed = SHED_STROKES;
+			oldest = i;
+			oldestUsed = lastUsed[i];
+		}
+		if (thumbnailBitmaps[i] && (oldest < 0 || thumbnailUsed[i] < oldestUsed)) {
+			shed = SHED_THUMBNAIL;
+			oldest = i;
+			oldestUsed = thumbnailUsed[i];
+		}
+#ifndef PBL_COLOR
+		if (i < ENTRIES && ditheredBitmaps[i] && (oldest < 0 || ditheredUsed[i] < oldestUsed)) {
+			shed = SHED_DITHERED;
+			oldest = i;
+			oldestUsed = ditheredUsed[i];
+		}
+#endif
+	}
 	
-	/* convert to a GPath */
-	GPath *temp = gpath_builder_create_path(builder);
+	switch (shed) {
+		case SHED_STROKES: free_stroke_spans(oldest); free_display_list(oldest); return true;
+		case SHED_THUMBNAIL: return free_thumbnail(oldest);
+#ifndef PBL_COLOR
+		case SHED_DITHERED: return free_dithered(oldest);
+#endif
+		default: return false;
+	}
+}
+
+/* shed the least recently used things in the caches until they're back under budget, and the heap has bytes
+   free for the next one with HEAP_RESERVE to spare - false if it still hasn't once there's nothing left to shed,
+   in which case whatever it was for shouldn't be kept */
+bool make_room(size_t bytes) {
+	while (cached_bytes() > CACHE_BUDGET || heap_bytes_free() < bytes + HEAP_RESERVE) {
+		if (!shed_oldest()) {
+			return false;
+		}
+	}
+	return true;
+}
 
-	/* prepare context & stroke path - outline */
-	graphics_context_set_stroke_color(ctx, LIM_COLOUR);
-	graphics_context_set_stroke_width(ctx, CUP_STROKE + LIM_STROKE);
-	gpath_draw_outline(ctx, temp);
+/* stroke a path - the first time a drink is painted the stroked pixels are recorded, after that they are
+   copied straight back into the frame buffer; the pixels under each stroke are the same every time a drink
+   is painted, so the result is identical to stroking. Every pixel the stroke touches is recorded, including
+   any it leaves the same colour, as what's under it can differ between the recording & a replay */
+void stroke_cached(GContext *ctx, GPath *path, int width, void (*stroke)(GContext *ctx, GPath *path)) {
+	int step = paintStep++;
+	if (paintItem >= entry_count() || step >= MAX_STROKES || paths != &fullSize) {
+		stroke(ctx, path);
+		return;
+	}
 	
-	/* prepare context & stroke path - 'fill' */
-	graphics_context_set_stroke_color(ctx, CUP_COLOUR);
-	graphics_context_set_stroke_width(ctx, CUP_STROKE);
-	gpath_draw_outline(ctx, temp);
+	/* replay if we have the pixels already */
+	SpanSet **slot = &strokeSpans[paintItem][step];
+	if (*slot) {
+		span_set_replay(*slot, ctx, paintOrigin, paintVisible);
+		cacheHits += prefetching ? 0 : 1;
+		return;
+	}
+	cacheMisses += prefetching ? 0 : 1;
 	
-	/* destroy objects */
-	gpath_builder_destroy(builder);
-	gpath_destroy(temp);
+	/* otherwise stroke, recording if nothing below was culled, the drink isn't mid-pour and there's room
+	   (capture_stroke only records if the layer is fully on screen). Recording takes two copies of the box,
+	   and the spans are allowed as much again */
+	GRect box = stroke_box(path, width);
+	if (paintItem == pourItem || paintCulled || !make_room(3 * box.size.w * box.size.h)) {
+		stroke(ctx, path);
+		return;
+	}
+	*slot = capture_stroke(ctx, box, paintOrigin, stroke, path);
+	if (*slot) {
+		strokeSpanBytes += span_set_size(*slot);
+		make_room(0);
+	}
 }
 
-/* draw the handle */
-void draw_handle(GContext *ctx) {
-	/* make an epmty GPathBuilder */
-	GPathBuilder *builder = gpath_builder_create(MAX_POINTS);
-	
-	/* build the path */
-	gpath_builder_move_to_point(builder, GPoint(114,30));
-	gpath_builder_curve_to_point(builder, GPoint(122,38), GPoint(120,25), GPoint(123,25));
-	gpath_builder_curve_to_point(builder, GPoint(111,45), GPoint(120,50), GPoint(110,47));
+/* a stroke width scaled along with the paths, never less than a pixel */
+int stroke_width(int width) {
+	return design_length(width);
+}
+
+/* stroke the cup - wide lim in the background colour, then the cup itself */
+void stroke_cup(GContext *ctx, GPath *path) {
+	set_stroke_colour(ctx, LIM_COLOUR);
+	graphics_context_set_stroke_width(ctx, stroke_width(CUP_STROKE + LIM_STROKE));
+	gpath_draw_outline(ctx, path);
+	set_stroke_colour(ctx, CUP_COLOUR);
+	graphics_context_set_stroke_width(ctx, stroke_width(CUP_STROKE));
+	gpath_draw_outline(ctx, path);
+}
+
+/* stroke the handle */
+void stroke_handle(GContext *ctx, GPath *path) {
+	set_stroke_colour(ctx, CUP_COLOUR);
+	graphics_context_set_stroke_width(ctx, stroke_width(HANDLE_STROKE));
+	gpath_draw_outline(ctx, path);
+}
+
+/* stroke the outline of a liquid */
+void stroke_outline(GContext *ctx, GPath *path) {
+	set_stroke_colour(ctx, OUTLINE_COLOUR);
+	graphics_context_set_stroke_width(ctx, stroke_width(OUTLINE_STROKE));
+	gpath_draw_outline(ctx, path);
+}
+
+/* free a cached thumbnail - returns false if there wasn't one */
+bool free_thumbnail(int i) {
+	if (!thumbnailBitmaps[i]) {
+		return false;
+	}
+	GSize size = gbitmap_get_bounds(thumbnailBitmaps[i]).size;
+	thumbnailBytes -= size.w * size.h;
+	gbitmap_destroy(thumbnailBitmaps[i]);
+	thumbnailBitmaps[i] = NULL;
+	return true;
+}
+
+/* free a drink's display list - returns false if it didn't have one */
+bool free_display_list(int i) {
+	if (!displayLists[i]) {
+		return false;
+	}
+	listBytes -= sizeof(DisplayList) + displayLists[i]->num_commands * sizeof(DisplayCommand);
+	free(displayLists[i]);
+	displayLists[i] = NULL;
+	return true;
+}
+
+/* free the paths in a set, so they're rebuilt next time they're needed */
+void free_path_set(PathSet *set) {
+	if (!set->arena) {
+		return;
+	}
+#if DRAW_TIMING
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "path arena: %d allocations, %d of %d bytes in %d chunks",
+			set->arena->num_allocations, (int)set->arena->bytes_used, (int)set->arena->bytes_reserved,
+			set->arena->num_chunks);
+#endif
+	path_arena_destroy(set->arena);
+	set->arena = NULL;
+	set->cupPath = NULL;
+	set->handlePath = NULL;
+	set->interiorPath = NULL;
+	set->liquidPath.points = NULL;
+}
+
+/* the thumbnail paths are only needed while the grid is showing - the thumbnails themselves are kept */
+void release_thumbnail_paths() {
+	free_path_set(&thumbnailSize);
+}
+
+/* the arena for the path set being drawn, made the first time something's allocated */
+PathArena* path_set_arena() {
+	if (!paths->arena) {
+		paths->arena = path_arena_create(PATH_ARENA_CHUNK);
+	}
+	return paths->arena;
+}
+
+/* forget everything cached for the synced drinks, as they're about to be replaced */
+void forget_synced_drinks() {
+	for (int i = ENTRIES; i < MAX_ENTRIES; i++) {
+		free_stroke_spans(i);
+		free_display_list(i);
+		free_thumbnail(i);
+		strokeStepsKnown[i] = false;
+		poured[i] = false;
+	}
+}
+
+/* release all cached paths and strokes */
+void destroy_graphics_cache() {
+	for (int i = 0; i < MAX_ENTRIES; i++) {
+		free_stroke_spans(i);
+		free_display_list(i);
+	}
 	
-	/* convert to a GPath */
-	GPath *temp = gpath_builder_create_path(builder);
+	free_path_set(&fullSize);
+	free_path_set(&previewSize);
+	free_path_set(&thumbnailSize);
 	
-	/* prepare context & stroke path - 'fill' */
-	graphics_context_set_stroke_color(ctx, CUP_COLOUR);
-	graphics_context_set_stroke_width(ctx, HANDLE_STROKE);
-	gpath_draw_outline(ctx, temp);
+	if (cupOverlay) {
+		gbitmap_destroy(cupOverlay);
+		cupOverlay = NULL;
+		overlayBytes = 0;
+	}
 	
-	/* destroy objects */
-	gpath_builder_destroy(builder);
-	gpath_destroy(temp);
+	for (int i = 0; i < MAX_ENTRIES; i++) {
+		free_thumbnail(i);
+	}
+	free_dithered_drinks();
 }
 
-/* draw an espresso shot - also used for ristretto despite it supposedly being a little shorter */
-void draw_espresso_shot(GContext *ctx) {
-	/* make an epmty GPathBuilder */
-	GPathBuilder *builder = gpath_builder_create(MAX_POINTS);
-	
-	/* build the path */
-	gpath_builder_move_to_point(builder, GPoint(20,75));
-	gpath_builder_line_to_point(builder, GPoint(100,75));
-	gpath_builder_curve_to_point(builder, GPoint(60,100), GPoint(95,85), GPoint(75,100));
-	gpath_builder_curve_to_point(builder, GPoint(20,75), GPoint(45,100), GPoint(25,85));
+/********************************************/
+/********* PATHS - PERSISTENT CACHE *********/
+/********************************************/
+
+/* FNV-1a, continuing from hash */
+uint32_t hash_bytes(uint32_t hash, const void *data, size_t size) {
+	const uint8_t *bytes = data;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+/* a hash of everything that goes into the flattened paths of the set being drawn */
+uint32_t path_set_hash() {
+	uint32_t hash = hash_bytes(2166136261u, &(int) { PATH_CACHE_VERSION }, sizeof(int));
+	hash = hash_bytes(hash, cupRecipe, sizeof(cupRecipe));
+	hash = hash_bytes(hash, interiorRecipe, sizeof(interiorRecipe));
+	hash = hash_bytes(hash, handleRecipe, sizeof(handleRecipe));
+	hash = hash_bytes(hash, &paths->transform, sizeof(GPathTransform));
+	return hash_bytes(hash, &paths->tolerance, sizeof(int32_t));
+}
+
+/* a path saved by an earlier run, if it was flattened from the same recipes with the same transform */
+GPath* restore_path(uint32_t key) {
+	if (!persist_exists(PERSIST_KEY_PATH_HASH) || !persist_exists(key)
+			|| (uint32_t)persist_read_int(PERSIST_KEY_PATH_HASH) != path_set_hash()) {
+		return NULL;
+	}
 	
-	/* convert to a GPath */
-	GPath *temp = gpath_builder_create_path(builder);
+	int size = persist_get_size(key);
+	PathArena *arena = path_set_arena();
+	GPath *path = arena ? path_arena_alloc_path(arena, size / sizeof(GPoint)) : NULL;
+	if (!path) {
+		return NULL;
+	}
+	path->num_points = persist_read_data(key, path->points, size) / sizeof(GPoint);
+	pathsRestored++;
+	return path;
+}
+
+/* fetch a path into slot - restored from persistent storage for full size drawing, otherwise flattened now */
+GPath* get_path(GPath **slot, uint32_t key, PathRecipe recipe, const GPoint *points) {
+	if (!*slot && paths == &fullSize) {
+		*slot = restore_path(key);
+	}
+	if (!*slot) {
+		*slot = build_path(recipe, points);
+	}
+	return *slot;
+}
+
+/* save the full size paths for the next run - paths already saved with the same hash aren't written again */
+void save_graphics_cache() {
+	paths = &fullSize;
+	uint32_t hash = path_set_hash();
+	bool sameHash = persist_exists(PERSIST_KEY_PATH_HASH) && (uint32_t)persist_read_int(PERSIST_KEY_PATH_HASH) == hash;
 	
-	/* prepare context */
-	graphics_context_set_stroke_color(ctx, OUTLINE_COLOUR);
-	graphics_context_set_stroke_width(ctx, OUTLINE_STROKE);
-	graphics_context_set_fill_color(ctx, COFFEE_COLOUR);
+	GPath *saved[] = { fullSize.cupPath, fullSize.handlePath, fullSize.interiorPath };
+	uint32_t keys[] = { PERSIST_KEY_CUP_PATH, PERSIST_KEY_HANDLE_PATH, PERSIST_KEY_INTERIOR_PATH };
+	for (unsigned int i = 0; i < ARRAY_LENGTH(saved); i++) {
+		if (sameHash && persist_exists(keys[i])) {
+			continue;
+		}
+		size_t size = saved[i] ? saved[i]->num_points * sizeof(GPoint) : 0;
+		if (size == 0 || size > PERSIST_DATA_MAX_LENGTH) {
+			/* not built this run, or too big for one key - flatten it next time */
+			persist_delete(keys[i]);
+		} else {
+			persist_write_data(keys[i], saved[i]->points, size);
+		}
+	}
 	
-	/* stroke path then fill path */
-	gpath_draw_filled(ctx, temp);
-	gpath_draw_outline(ctx, temp);
+	if (!sameHash) {
+		persist_write_int(PERSIST_KEY_PATH_HASH, hash);
+	}
+}
+
+/* true if any paths came from persistent storage this run */
+bool graphics_cache_restored() {
+	return pathsRestored > 0;
+}
+
+/********************************************/
+/******** LIQUIDS - PARAMETRIC LEVELS *******/
+/********************************************/
+
+/* flatten the cup interior once, and make room for the biggest polygon clipping it can produce - false if
+   either couldn't be had, so there's no liquid to draw */
+bool build_interior_profile() {
+	if (paths->interiorPath && paths->liquidPath.points) {
+		return true;
+	}
+	if (!get_path(&paths->interiorPath, PERSIST_KEY_INTERIOR_PATH, add_bowl, interiorRecipe)) {
+		return false;
+	}
+	PathArena *arena = path_set_arena();
+	paths->liquidPath.points = arena ? path_arena_alloc(arena, 2 * paths->interiorPath->num_points * sizeof(GPoint)) : NULL;
+	if (!paths->liquidPath.points) {
+		return false;
+	}
 	
-	/* destroy objects */
-	gpath_builder_destroy(builder);
-	gpath_destroy(temp);
+	/* the extents of the profile, for culling liquids */
+	paths->interiorBottom = 0;
+	paths->interiorLeft = paths->interiorPath->points[0].x;
+	paths->interiorRight = paths->interiorLeft;
+	for (uint32_t i = 0; i < paths->interiorPath->num_points; i++) {
+		GPoint p = paths->interiorPath->points[i];
+		paths->interiorBottom = (p.y > paths->interiorBottom) ? p.y : paths->interiorBottom;
+		paths->interiorLeft = (p.x < paths->interiorLeft) ? p.x : paths->interiorLeft;
+		paths->interiorRight = (p.x > paths->interiorRight) ? p.x : paths->interiorRight;
+	}
+	return true;
 }
 
-/* helper routine for drawing water to top */
-void draw_to_top(GContext *ctx, GColor color) {
-	/* make an epmty GPathBuilder */
-	GPathBuilder *builder = gpath_builder_create(MAX_POINTS);
+/* the liquid polygon for a given level - the interior profile with everything above the level cut away;
+   the polygon is written into a scratch path, so it's only valid until the next call. NULL if there's no profile */
+GPath* liquid_path(int level) {
+	if (!build_interior_profile()) {
+		return NULL;
+	}
 	
-	/* build the path */
-	gpath_builder_move_to_point(builder, GPoint(8,35));
-	gpath_builder_line_to_point(builder, GPoint(110,35));
-	gpath_builder_curve_to_point(builder, GPoint(60,100), GPoint(110,70), GPoint(80,100));
-	gpath_builder_curve_to_point(builder, GPoint(8,35), GPoint(40,100), GPoint(8,70));
+	/* walk the edges, keeping points below the level and adding one wherever an edge crosses it */
+	GPoint *in = paths->interiorPath->points;
+	uint32_t n = paths->interiorPath->num_points;
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < n; i++) {
+		GPoint a = in[i];
+		GPoint b = in[(i + 1) % n];
+		bool aBelow = a.y >= level;
+		bool bBelow = b.y >= level;
+		if (aBelow) {
+			paths->liquidPath.points[count++] = a;
+		}
+		if (aBelow != bBelow) {
+			paths->liquidPath.points[count++] = GPoint(a.x + (b.x - a.x) * (level - a.y) / (b.y - a.y), level);
+		}
+	}
+	paths->liquidPath.num_points = count;
+	return &paths->liquidPath;
+}
+
+/* start pouring a drink the first time it appears - returns false if it has been poured already */
+bool start_pour(int i) {
+	if (i < 0 || i >= entry_count() || poured[i]) {
+		return false;
+	}
+	poured[i] = true;
+	pourItem = i;
+	pourProgress = 0;
+	return true;
+}
+
+/* progress runs from 0 (empty cup) to ANIMATION_NORMALIZED_MAX (full) */
+void set_pour_progress(int progress) {
+	pourProgress = progress;
+}
+
+void end_pour() {
+	pourItem = -1;
+}
+
+/********************************************/
+/**************** THUMBNAILS ****************/
+/********************************************/
+
+/* draw a whole drink, cup included, with the thumbnail paths at offset - nothing here is cached or culled */
+void render_thumbnail(int i, GContext *ctx, GPoint offset) {
+	paths = &thumbnailSize;
+	paintOffset = offset;
+	draw_graphics_image(i, ctx, GPointZero, GRect(-offset.x, -offset.y, 0x7fff, 0x7fff));
+	draw_cup_and_handle(ctx);
+	paintOffset = GPointZero;
+	paths = &fullSize;
+}
+
+/* draw a drink's thumbnail into cell (layer coordinates, sized with set_thumbnail_size) - the first time
+   it's rendered and copied out as a bitmap, after that it's just blitted; origin is where the layer is on screen */
+void draw_thumbnail(int i, GContext *ctx, GRect cell, GPoint origin) {
+	if (i < 0 || i >= entry_count()) {
+		return;
+	}
+	thumbnailUsed[i] = ++useClock;
 	
-	/* convert to a GPath */
-	GPath *temp = gpath_builder_create_path(builder);
+	if (thumbnailBitmaps[i]) {
+		graphics_draw_bitmap_in_rect(ctx, thumbnailBitmaps[i], cell);
+		return;
+	}
 	
-	/* prepare context */
-	graphics_context_set_stroke_color(ctx, OUTLINE_COLOUR);
-	graphics_context_set_stroke_width(ctx, OUTLINE_STROKE);
-	graphics_context_set_fill_color(ctx, color);
+	/* copying it out takes the bitmap and a copy of the cell - and render_thumbnail leaves it the drink being
+	   painted, so its own caches are kept */
+	render_thumbnail(i, ctx, cell.origin);
+	if (!make_room(2 * cell.size.w * cell.size.h)) {
+		return;
+	}
+	thumbnailBitmaps[i] = capture_bitmap(ctx, cell, origin);
+	if (thumbnailBitmaps[i]) {
+		thumbnailBytes += cell.size.w * cell.size.h;
+		make_room(0);
+	}
+}
+
+/********************************************/
+/******* PATHS - BUILDING FROM RECIPES ******/
+/********************************************/
+
+/* scale & flatten a builder for the path set being drawn */
+GPathBuilder* prepare_builder(GPathBuilder *builder) {
+	if (!builder) {
+		return NULL;
+	}
+	gpath_builder_set_transform(builder, paths->transform);
+	gpath_builder_set_tolerance(builder, paths->tolerance);
+	return builder;
+}
+
+GPath* arena_allocator(uint32_t num_points, void *context) {
+	return path_arena_alloc_path(context, num_points);
+}
+
+/* run a recipe through a counting builder first, so the real builder is exactly big enough */
+GPath* build_path(PathRecipe recipe, const GPoint *points) {
+	GPathBuilder *builder = prepare_builder(gpath_builder_create_counter());
+	if (!builder) {
+		return NULL;
+	}
+	recipe(builder, points);
+	uint32_t count = builder->num_points;
+	gpath_builder_destroy(builder);
+	if (count > MAX_POINTS) {
+		APP_LOG(APP_LOG_LEVEL_ERROR, "path flattened to %d points, more than %d", (int)count, MAX_POINTS);
+		return NULL;
+	}
 	
-	/* stroke path then fill path */
-	gpath_draw_filled(ctx, temp);
-	gpath_draw_outline(ctx, temp);
+	builder = prepare_builder(gpath_builder_create(count));
+	if (!builder) {
+		return NULL;
+	}
+	recipe(builder, points);
+	if (builder->overflowed) {
+		/* the second pass has to match the count - a partial path would draw the wrong shape */
+		APP_LOG(APP_LOG_LEVEL_ERROR, "path overflowed its builder - %d of %d points", (int)builder->num_points, (int)count);
+		gpath_builder_destroy(builder);
+		return NULL;
+	}
 	
-	/* destroy objects */
+	/* convert to a GPath in the set's arena, destroy the builder */
+	PathArena *arena = path_set_arena();
+	GPath *temp = arena ? gpath_builder_create_path_with(builder, arena_allocator, arena) : NULL;
 	gpath_builder_destroy(builder);
-	gpath_destroy(temp);
+	return temp;
 }
 
-/* draw foam to top */
-void draw_foam_to_top(GContext *ctx) {
-	//draw_to_top(ctx, FOAM_COLOUR);
+/* a bowl shape - flat top, curving down to a point at the bottom middle */
+void add_bowl(GPathBuilder *builder, const GPoint *points) {
+	gpath_builder_move_to_point(builder, points[0]);
+	gpath_builder_line_to_point(builder, points[1]);
+	gpath_builder_curve_to_point(builder, points[2], points[3], points[4]);
+	gpath_builder_curve_to_point(builder, points[5], points[6], points[7]);
+}
+
+/* the handle - two curves */
+void add_handle(GPathBuilder *builder, const GPoint *points) {
+	gpath_builder_move_to_point(builder, points[0]);
+	gpath_builder_curve_to_point(builder, points[1], points[2], points[3]);
+	gpath_builder_curve_to_point(builder, points[4], points[5], points[6]);
+}
+
+/********************************************/
+/************* DITHERED DRINKS **************/
+/********************************************/
+
+#ifndef PBL_COLOR
+/* free a loaded dithered drink - returns false if it wasn't loaded */
+bool free_dithered(int i) {
+	if (!ditheredBitmaps[i]) {
+		return false;
+	}
+	ditheredBytes -= gbitmap_get_bytes_per_row(ditheredBitmaps[i]) * ditheredBoxes[i].size.h;
+	gbitmap_destroy(ditheredBitmaps[i]);
+	ditheredBitmaps[i] = NULL;
+	return true;
+}
+
+/* read a drink's dithered rows out of the resource into a new bitmap - see tools/dither_drinks.py for the
+   layout; false if it was dithered at a different size, or there isn't the memory */
+bool load_dithered(int i) {
+#if DRAW_TIMING
+	time_t seconds, startSeconds;
+	uint16_t millis, startMillis;
+	time_ms(&startSeconds, &startMillis);
+#endif
 	
-	graphics_context_set_stroke_color(ctx, FOAM_COLOUR);
+	ResHandle handle = resource_get_handle(RESOURCE_ID_DITHERED_DRINKS);
+	uint8_t header[DITHERED_HEADER_SIZE];
+	resource_load_byte_range(handle, 0, header, DITHERED_HEADER_SIZE);
+	if (i >= header[0] || header[1] != DESIGN_WIDTH || header[2] != DESIGN_HEIGHT) {
+		return false;
+	}
+	uint8_t entry[DITHERED_ENTRY_SIZE];
+	resource_load_byte_range(handle, DITHERED_HEADER_SIZE + i * DITHERED_ENTRY_SIZE, entry, DITHERED_ENTRY_SIZE);
+	GRect box = GRect(entry[0], entry[1], entry[2], entry[3]);
+	if (box.size.w == 0 || box.size.h == 0) {
+		return false;
+	}
 	
-	for(int i = 10; i <= 111; i += 4) {
-			graphics_draw_circle(ctx, GPoint( i, 37), 3);
+	int rowBytes = (box.size.w + 7) / 8;
+	GBitmap *bitmap = make_room(rowBytes * box.size.h) ? gbitmap_create_blank(box.size, GBitmapFormat1Bit) : NULL;
+	if (!bitmap) {
+		return false;
 	}
+	uint8_t *data = gbitmap_get_data(bitmap);
+	int stride = gbitmap_get_bytes_per_row(bitmap);
+	size_t rows = DITHERED_HEADER_SIZE + header[0] * DITHERED_ENTRY_SIZE + (entry[4] | (entry[5] << 8));
+	for (int y = 0; y < box.size.h; y++) {
+		resource_load_byte_range(handle, rows + y * rowBytes, &data[y * stride], rowBytes);
+	}
+	
+	ditheredBitmaps[i] = bitmap;
+	ditheredBoxes[i] = box;
+	ditheredBytes += stride * box.size.h;
+	make_room(0);
 	
-	for(int i = 12; i <= 109; i += 4) {
-			graphics_draw_circle(ctx, GPoint( i, 42), 3);
+#if DRAW_TIMING
+	time_ms(&seconds, &millis);
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "dithered drink %d: %d bytes, loaded in %d ms", i, stride * box.size.h,
+			(int)((seconds - startSeconds) * 1000 + millis - startMillis));
+#endif
+	return true;
+}
+#endif
+
+/* blit a drink dithered at build time - false if it has to be drawn: on colour screens, while it's pouring, for
+   thumbnails and synced drinks, or if the draw layer isn't the size the drinks were dithered at */
+bool draw_dithered(int i, GContext *ctx) {
+#if defined(PBL_COLOR) || !DRAW_DITHERED
+	return false;
+#else
+	GPathTransform *transform = &paths->transform;
+	if (i >= ENTRIES || i == pourItem || paths == &thumbnailSize || transform->scale_x != GPATH_TRANSFORM_ONE
+			|| transform->scale_y != GPATH_TRANSFORM_ONE || transform->offset.x != 0 || transform->offset.y != 0) {
+		return false;
+	}
+	if (!ditheredBitmaps[i] && !load_dithered(i)) {
+		return false;
 	}
 	
-	for(int i = 14; i <= 107; i += 4) {
-			graphics_draw_circle(ctx, GPoint( i, 47), 3);
+	ditheredUsed[i] = ++useClock;
+	if (component_visible(ditheredBoxes[i])) {
+		graphics_draw_bitmap_in_rect(ctx, ditheredBitmaps[i], ditheredBoxes[i]);
+	}
+	return true;
+#endif
+}
+
+void free_dithered_drinks() {
+#ifndef PBL_COLOR
+	for (int i = 0; i < ENTRIES; i++) {
+		free_dithered(i);
+	}
+#endif
+}
+
+/********************************************/
+/************** DISPLAY LISTS ***************/
+/********************************************/
+
+/* add a command to the display list being recorded - if there's too many, the drink just isn't recorded */
+void record_command(DisplayCommand command) {
+	if (recordingCount < 0) {
+		return;
+	}
+	if (recordingCount >= MAX_COMMANDS) {
+		recordingCount = -1;
+		return;
+	}
+	recording[recordingCount++] = command;
+}
+
+/* set the stroke colour - every stroke colour goes through here, so the recording always knows the colour in
+   force; only recorded when it's a change, so replays never set the same colour twice */
+void set_stroke_colour(GContext *ctx, GColor color) {
+	if (recordingCount >= 0 && (!recordedStrokeKnown || !gcolor_equal(color, recordedStroke))) {
+		record_command((DisplayCommand) { .op = DL_STROKE_COLOUR, .color = color });
+		recordedStroke = color;
+		recordedStrokeKnown = true;
+	}
+	graphics_context_set_stroke_color(ctx, color);
+}
+
+/* paint a recorded drink - the same calls the draw functions would have made, without working them out */
+void replay_display_list(DisplayList *list, GContext *ctx) {
+	for (int i = 0; i < list->num_commands; i++) {
+		DisplayCommand *command = &list->commands[i];
+		switch (command->op) {
+			case DL_LIQUID:
+				paint_liquid(ctx, command->y, command->color);
+				break;
+			case DL_CIRCLES:
+				paint_circles(ctx, command->y, command->from, command->to, command->step, command->radius);
+				break;
+			case DL_STROKE_COLOUR:
+				graphics_context_set_stroke_color(ctx, command->color);
+				break;
+		}
+	}
+}
+
+/********************************************/
+/***** IMAGES - DETAILED DRAW FUNCTIONS *****/
+/********************************************/
+
+/* fill a liquid to the given level (design coordinates) then stroke its outline - while a drink is pouring every level rises
+   from the bottom of the cup, and the outline changes each frame so isn't cached */
+void draw_liquid(GContext *ctx, int level, GColor color) {
+	level = design_point(0, level).y;
+	if (paintItem == pourItem && paths != &thumbnailSize) {
+		if (!build_interior_profile()) {
+			return;
+		}
+		level = paths->interiorBottom - (paths->interiorBottom - level) * pourProgress / ANIMATION_NORMALIZED_MAX;
+	}
+	record_command((DisplayCommand) { .op = DL_LIQUID, .color = color, .y = level });
+	paint_liquid(ctx, level, color);
+}
+
+/* fill & stroke a liquid at a level already on the layer - skipped altogether if none of it can be seen */
+void paint_liquid(GContext *ctx, int level, GColor color) {
+	bool pouring = (paintItem == pourItem) && (paths != &thumbnailSize);
+	if (!build_interior_profile()) {
+		paintStep++;
+		return;
+	}
+	GRect box = GRect(paths->interiorLeft - OUTLINE_STROKE, level - OUTLINE_STROKE,
+			paths->interiorRight - paths->interiorLeft + 2 * OUTLINE_STROKE, paths->interiorBottom - level + 2 * OUTLINE_STROKE);
+	GPath *path = liquid_path(level);
+	if (!path || path->num_points < 3 || !component_visible(box)) {
+		paintStep++;
+		return;
 	}
 	
-	for(int i = 16; i <= 105; i += 4) {
-			graphics_draw_circle(ctx, GPoint( i, 52), 3);
+	gpath_move_to(path, paintOffset);
+	graphics_context_set_fill_color(ctx, color);
+	gpath_draw_filled(ctx, path);
+	if (paths == &previewSize) {
+		paintStep++;
+	} else if (pouring) {
+		paintStep++;
+		stroke_outline(ctx, path);
+	} else {
+		stroke_cached(ctx, path, OUTLINE_STROKE, stroke_outline);
+	}
+}
+
+/* draw the cup */
+void draw_cup(GContext *ctx) {
+	if (!get_path(&paths->cupPath, PERSIST_KEY_CUP_PATH, add_bowl, cupRecipe)) {
+		return;
+	}
+	gpath_move_to(paths->cupPath, paintOffset);
+	stroke_cup(ctx, paths->cupPath);
+}
+
+/* draw the handle */
+void draw_handle(GContext *ctx) {
+	if (!get_path(&paths->handlePath, PERSIST_KEY_HANDLE_PATH, add_handle, handleRecipe)) {
+		return;
 	}
+	gpath_move_to(paths->handlePath, paintOffset);
+	stroke_handle(ctx, paths->handlePath);
+}
+
+/* the cup & handle together, as drawn into the cached overlay */
+void draw_cup_and_handle(GContext *ctx) {
+	draw_cup(ctx);
+	draw_handle(ctx);
+}
+
+/* draw the cup & handle for the cup layer - captured into an overlay the first time, then just blitted */
+void draw_cup_frame(GContext *ctx, GPoint origin) {
+	if (!cupOverlay) {
+		draw_cup_and_handle(ctx);
+		if (!paths->cupPath || !paths->handlePath) {
+			return;
+		}
+		
+		/* capture over the area both strokes can touch */
+		GRect cup = stroke_box(paths->cupPath, CUP_STROKE + LIM_STROKE);
+		GRect handle = stroke_box(paths->handlePath, HANDLE_STROKE);
+		int right = (handle.origin.x + handle.size.w > cup.origin.x + cup.size.w) ? handle.origin.x + handle.size.w : cup.origin.x + cup.size.w;
+		int bottom = (handle.origin.y + handle.size.h > cup.origin.y + cup.size.h) ? handle.origin.y + handle.size.h : cup.origin.y + cup.size.h;
+		cupBox = GRect(cup.origin.x, cup.origin.y, right - cup.origin.x, bottom - cup.origin.y);
+		/* the overlay is kept for good, but it takes the bitmap and two copies of the box to make */
+		if (make_room(3 * cupBox.size.w * cupBox.size.h)) {
+			cupOverlay = capture_overlay(ctx, cupBox, origin, draw_cup_and_handle);
+			overlayBytes = cupOverlay ? cupBox.size.w * cupBox.size.h : 0;
+		}
+		return;
+	}
+	
+	graphics_context_set_compositing_mode(ctx, GCompOpSet);
+	graphics_draw_bitmap_in_rect(ctx, cupOverlay, cupBox);
+	graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+}
+
+/* draw an espresso shot - also used for ristretto despite it supposedly being a little shorter */
+void draw_espresso_shot(GContext *ctx) {
+	draw_liquid(ctx, LEVEL_SHOT, COFFEE_COLOUR);
+}
+
+/* helper routine for drawing water to top */
+void draw_to_top(GContext *ctx, GColor color) {
+	draw_liquid(ctx, LEVEL_TOP, color);
+}
+
+/* draw a row of foam bubbles at height y, from x = from to to (design coordinates) */
+void draw_foam_row(GContext *ctx, int y, int from, int to, int step, int radius) {
+	GPoint start = design_point(from, y);
+	to = design_point(to, 0).x;
+	step = design_length(step);
+	radius = design_length(radius);
+	record_command((DisplayCommand) { .op = DL_CIRCLES, .y = start.y, .from = start.x, .to = to, .step = step,
+			.radius = radius });
+	paint_circles(ctx, start.y, start.x, to, step, radius);
+}
+
+/* a row of circles already on the layer - skipped if the row can't be seen */
+void paint_circles(GContext *ctx, int y, int from, int to, int step, int radius) {
+	if (!component_visible(GRect(from - radius, y - radius, to - from + 2 * radius + 1, 2 * radius + 1))) {
+		return;
+	}
+	step = (paths == &previewSize) ? 2 * step : step;
+	for(int i = from; i <= to; i += step) {
+		graphics_draw_circle(ctx, GPoint( i + paintOffset.x, y + paintOffset.y), radius);
+	}
+}
+
+/* draw foam to top */
+void draw_foam_to_top(GContext *ctx) {
+	//draw_to_top(ctx, FOAM_COLOUR);
 	
+	/* foam goes on once the pour is finished */
+	if (paintItem == pourItem && paths != &thumbnailSize) {
+		return;
+	}
 	
+	set_stroke_colour(ctx, FOAM_COLOUR);
+	draw_foam_row(ctx, 37, 10, 111, 4, 3);
+	draw_foam_row(ctx, 42, 12, 109, 4, 3);
+	draw_foam_row(ctx, 47, 14, 107, 4, 3);
+	draw_foam_row(ctx, 52, 16, 105, 4, 3);
 }
 
 /* draw water to top, using helper function */
@@ -323,98 +1353,31 @@ void draw_water_to_top(GContext *ctx) {
 
 /* draw milk half way */
 void draw_milk_to_mid(GContext *ctx) {
-	/* make an epmty GPathBuilder */
-	GPathBuilder *builder = gpath_builder_create(MAX_POINTS);
-	
-	/* build the path */
-	gpath_builder_move_to_point(builder, GPoint(15,55));
-	gpath_builder_line_to_point(builder, GPoint(105,55));
-	gpath_builder_curve_to_point(builder, GPoint(60,100), GPoint(105,75), GPoint(80,100));
-	gpath_builder_curve_to_point(builder, GPoint(15,55), GPoint(40,100), GPoint(15,75));
-	
-	/* convert to a GPath */
-	GPath *temp = gpath_builder_create_path(builder);
-	
-	/* prepare context */
-	graphics_context_set_stroke_color(ctx, OUTLINE_COLOUR);
-	graphics_context_set_stroke_width(ctx, OUTLINE_STROKE);
-	graphics_context_set_fill_color(ctx, MILK_COLOUR);
-	
-	/* stroke path then fill path */
-	gpath_draw_filled(ctx, temp);
-	gpath_draw_outline(ctx, temp);
-	
-	/* destroy objects */
-	gpath_builder_destroy(builder);
-	gpath_destroy(temp);
+	draw_liquid(ctx, LEVEL_MID, MILK_COLOUR);
 }
 
 /* draw milk nearly to the top */
 void draw_milk_to_high(GContext *ctx) {
-	/* make an epmty GPathBuilder */
-	GPathBuilder *builder = gpath_builder_create(MAX_POINTS);
-	
-	/* build the path */
-	gpath_builder_move_to_point(builder, GPoint(10,42));
-	gpath_builder_line_to_point(builder, GPoint(110,42));
-	gpath_builder_curve_to_point(builder, GPoint(60,100), GPoint(110,70), GPoint(80,100));
-	gpath_builder_curve_to_point(builder, GPoint(10,42), GPoint(40,100), GPoint(10,70));
-	
-	/* convert to a GPath */
-	GPath *temp = gpath_builder_create_path(builder);
-	
-	/* prepare context */
-	graphics_context_set_stroke_color(ctx, OUTLINE_COLOUR);
-	graphics_context_set_stroke_width(ctx, OUTLINE_STROKE);
-	graphics_context_set_fill_color(ctx, MILK_COLOUR);
-	
-	/* stroke path then fill path */
-	gpath_draw_filled(ctx, temp);
-	gpath_draw_outline(ctx, temp);
-	
-	/* destroy objects */
-	gpath_builder_destroy(builder);
-	gpath_destroy(temp);
+	draw_liquid(ctx, LEVEL_HIGH, MILK_COLOUR);
 }
 
-/***** NOT CURRENTLY USED *****/
+/* draw milk a little above the espresso shot - only synced drinks use it */
 void draw_milk_to_low(GContext *ctx) {
-	/* make an epmty GPathBuilder */
-	GPathBuilder *builder = gpath_builder_create(MAX_POINTS);
-	
-	/* build the path */
-	gpath_builder_move_to_point(builder, GPoint(12,42));
-	gpath_builder_line_to_point(builder, GPoint(108,42));
-	gpath_builder_curve_to_point(builder, GPoint(60,100), GPoint(108,70), GPoint(80,100));
-	gpath_builder_curve_to_point(builder, GPoint(12,42), GPoint(40,100), GPoint(12,70));
-	
-	/* convert to a GPath */
-	GPath *temp = gpath_builder_create_path(builder);
-	
-	/* prepare context */
-	graphics_context_set_stroke_color(ctx, OUTLINE_COLOUR);
-	graphics_context_set_stroke_width(ctx, OUTLINE_STROKE);
-	graphics_context_set_fill_color(ctx, MILK_COLOUR);
-	
-	/* stroke path then fill path */
-	gpath_draw_filled(ctx, temp);
-	gpath_draw_outline(ctx, temp);
-	
-	/* destroy objects */
-	gpath_builder_destroy(builder);
-	gpath_destroy(temp);
+	draw_liquid(ctx, LEVEL_LOW, MILK_COLOUR);
 }
 
 /* draw foam just above the espresso shot */
 void draw_foam_to_very_low(GContext *ctx) {
 	
-	graphics_context_set_stroke_color(ctx, FOAM_COLOUR);
-	
-	for(int i = 20; i <= 100; i += 3) {
-		graphics_draw_circle(ctx, GPoint( i, 72), 4);
+	/* foam goes on once the pour is finished */
+	if (paintItem == pourItem && paths != &thumbnailSize) {
+		return;
 	}
 	
-	/* make an epmty GPathBuilder */
+	set_stroke_colour(ctx, FOAM_COLOUR);
+	draw_foam_row(ctx, 72, 20, 100, 3, 4);
+	
+	/* make an empty GPathBuilder */
 	//GPathBuilder *builder = gpath_builder_create(MAX_POINTS);
 	
 	/* build the path */
@@ -438,4 +1401,27 @@ void draw_foam_to_very_low(GContext *ctx) {
 	/* destroy objects */
 	//gpath_builder_destroy(builder);
 	//gpath_destroy(temp);
-}
\ No newline at end of file
+}
+/********************************************/
+/********** SYNCED DRINKS - PAINTING ********/
+/********************************************/
+
+/* the layers a synced drink can use, in the order of the SYNC_LAYER_ numbers the phone sends */
+void (*const syncedLayerPaint[SYNC_LAYER_COUNT])(GContext *ctx) = {
+	draw_espresso_shot,
+	draw_water_to_top,
+	draw_foam_to_top,
+	draw_milk_to_mid,
+	draw_milk_to_high,
+	draw_milk_to_low,
+	draw_foam_to_very_low,
+};
+
+/* paint a synced drink's layers in the order they were sent, the same as a catalog entry's paint */
+void paint_synced_drink(GContext *ctx, int n) {
+	int numLayers;
+	const uint8_t *layers = catalog_sync_layers(n, &numLayers);
+	for (int i = 0; i < numLayers; i++) {
+		syncedLayerPaint[layers[i]](ctx);
+	}
+}
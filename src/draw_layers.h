@@ -1,10 +1,75 @@
 #pragma once
 #include <pebble.h>
+
+/* set to 1 to time painting - display list replays, paints by quality, dithered blits - along with text decodes,
+   loads, the first frame & syncs, and log it with the caches' stats. The timing itself costs a little every time,
+   so it's off normally */
+#define DRAW_TIMING 0
+
+/* set to 0 to draw the built in drinks on black & white screens too, rather than blit them dithered - for timing
+   the two against each other */
+#ifndef DRAW_DITHERED
+#define DRAW_DITHERED 1
+#endif
 	
+int entry_count();
+int max_entry_count();
 int next_up(int current);
 int next_down(int current);
 
-char* header_text(int i);
-char* detail_text(int i);
+/* the first drink for a letter (a name index bucket), built in or synced - -1 if there are none */
+int first_entry_in_bucket(int bucket);
+
+const char* header_text(int i);
+const char* detail_text(int i);
+void release_detail_text();
+
+/* size of the draw layers - the drawings are scaled & centred to fit, once, as paths are built */
+void set_graphics_size(GSize size);
+
+/* draw a drink - origin is where the layer sits on screen, used to cache the strokes, and anything entirely
+   outside visible (layer coordinates) is skipped */
+void draw_graphics_image(int recordNum, GContext *ctx, GPoint origin, GRect visible);
+void get_graphics_draw_stats(int *drawn, int *culled, bool reset);
+/* display lists recorded & replayed, the commands in them, and the time replays took (DRAW_TIMING only) */
+void get_display_list_stats(int *recorded, int *replays, int *recordedCommands, int *replayedCommands,
+		int *millis);
+/* full size paints of the built in drinks - blitted dithered (black & white only) or drawn - and the time each
+   took (DRAW_TIMING only) */
+void get_dithered_stats(int *blits, int *blitsMillis, int *draws, int *drawsMillis);
+
+/* how carefully drawings are painted - preview is cheaper, for while they're moving */
+typedef enum {
+	QUALITY_FULL,
+	QUALITY_PREVIEW,
+} GraphicsQuality;
+void set_graphics_quality(GraphicsQuality level);
+
+/* draw the cup & handle, which are the same for every drink and live in their own layer on top */
+void draw_cup_frame(GContext *ctx, GPoint origin);
+
+/* idle prefetch - paints a drink into bounds (cleared to background before & after) to record its strokes */
+bool graphics_image_cached(int i);
+bool prefetch_graphics_image(int i, GContext *ctx, GPoint origin, GRect bounds, GColor background);
+void get_graphics_cache_stats(int *hits, int *misses);
+
+/* thumbnails - rendered once at a small size and coarse flattening, then kept as bitmaps */
+void set_thumbnail_size(GSize size);
+void draw_thumbnail(int i, GContext *ctx, GRect cell, GPoint origin);
+
+/* the grid's paths are freed with it */
+void release_thumbnail_paths();
+
+/* flattened paths are saved between runs - save before destroying the cache */
+void save_graphics_cache();
+bool graphics_cache_restored();
+
+void destroy_graphics_cache();
+
+/* the synced drinks are being replaced - drop everything cached for them */
+void forget_synced_drinks();
 
-void draw_graphics_image(int recordNum, GContext *ctx);
\ No newline at end of file
+/* pour animation - start_pour is false if the drink has been poured already, progress is 0 to ANIMATION_NORMALIZED_MAX */
+bool start_pour(int i);
+void set_pour_progress(int progress);
+void end_pour();
\ No newline at end of file
@@ -3,14 +3,58 @@
 
 const int fixedpoint_base = 16;
 
-// Angle below which we're not going to process with recursion
+// Default angle below which we're not going to process with recursion
 int32_t max_angle_tolerance = (TRIG_MAX_ANGLE / 360) * 10;
 
-bool recursive_bezier_fixed(GPathBuilder *builder,
-                            int32_t x1, int32_t y1,
-                            int32_t x2, int32_t y2,
-                            int32_t x3, int32_t y3,
-                            int32_t x4, int32_t y4) {
+// Subdivision always stops this deep, so one curve never adds more than 2^depth points however
+// degenerate it is (coincident control points, cusps, jitter)
+#define MAX_RECURSION_DEPTH 8
+
+static bool add_point(GPathBuilder *builder, GPoint to_point);
+
+// Scale one coordinate into the fixedpoint realm, rounding to the nearest step - the product is
+// taken in 64 bits, as a 16 bit coordinate times a scale above 1:1 doesn't fit in 32
+static int32_t transform_fixed(int32_t value, int32_t scale, int32_t offset) {
+  int64_t scaled = (int64_t)value * scale * fixedpoint_base;
+  int64_t rounding = (scaled < 0) ? -GPATH_TRANSFORM_ONE / 2 : GPATH_TRANSFORM_ONE / 2;
+  return (int32_t)((scaled + rounding) / GPATH_TRANSFORM_ONE) + offset * fixedpoint_base;
+}
+
+// Round a point in the fixedpoint realm to the nearest pixel
+static GPoint fixed_to_point(int32_t x, int32_t y) {
+  int32_t half = fixedpoint_base / 2;
+  return GPoint((x + (x < 0 ? -half : half)) / fixedpoint_base,
+                (y + (y < 0 ? -half : half)) / fixedpoint_base);
+}
+
+GPoint gpath_transform_point(const GPathTransform *transform, GPoint point) {
+  return fixed_to_point(transform_fixed(point.x, transform->scale_x, transform->offset.x),
+                        transform_fixed(point.y, transform->scale_y, transform->offset.y));
+}
+
+// Angle of a segment in pixels - atan2_lookup takes 16 bit arguments, so long segments are halved
+// until they fit, which keeps their direction
+static int32_t segment_angle(int32_t dx, int32_t dy) {
+  dx /= fixedpoint_base;
+  dy /= fixedpoint_base;
+  while (dx > INT16_MAX || dx < -INT16_MAX || dy > INT16_MAX || dy < -INT16_MAX) {
+    dx /= 2;
+    dy /= 2;
+  }
+  return atan2_lookup((int16_t)dy, (int16_t)dx);
+}
+
+// Difference between two angles, the short way round
+static int32_t angle_between(int32_t a, int32_t b) {
+  int32_t d = abs(a - b);
+  return (d > TRIG_MAX_ANGLE / 2) ? TRIG_MAX_ANGLE - d : d;
+}
+
+static bool recursive_bezier_fixed(GPathBuilder *builder, int depth,
+                                   int32_t x1, int32_t y1,
+                                   int32_t x2, int32_t y2,
+                                   int32_t x3, int32_t y3,
+                                   int32_t x4, int32_t y4) {
   // Calculate all the mid-points of the line segments
   int32_t x12   = (x1 + x2) / 2;
   int32_t y12   = (y1 + y2) / 2;
@@ -26,49 +70,49 @@ bool recursive_bezier_fixed(GPathBuilder *builder,
   int32_t y1234 = (y123 + y234) / 2;
 
   // Angle Condition
-  int32_t a23 = atan2_lookup((int16_t)((y3 - y2) / fixedpoint_base),
-                             (int16_t)((x3 - x2) / fixedpoint_base));
-  int32_t da1 = abs(a23 - atan2_lookup((int16_t)((y2 - y1) / fixedpoint_base),
-                                       (int16_t)((x2 - x1) / fixedpoint_base)));
-  int32_t da2 = abs(atan2_lookup((int16_t)((y4 - y3) / fixedpoint_base),
-                                 (int16_t)((x4 - x3) / fixedpoint_base)) - a23);
-
-  if (da1 >= TRIG_MAX_ANGLE) {
-    da1 = TRIG_MAX_ANGLE - da1;
-  }
+  int32_t a23 = segment_angle(x3 - x2, y3 - y2);
+  int32_t da1 = angle_between(a23, segment_angle(x2 - x1, y2 - y1));
+  int32_t da2 = angle_between(segment_angle(x4 - x3, y4 - y3), a23);
 
-  if (da2 >= TRIG_MAX_ANGLE) {
-    da2 = TRIG_MAX_ANGLE - da2;
+  // A curve no longer than a pixel can't get any smoother
+  int32_t span = abs(x2 - x1) + abs(x3 - x2) + abs(x4 - x3) + abs(y2 - y1) + abs(y3 - y2) + abs(y4 - y3);
+
+  if (depth > builder->max_depth) {
+    builder->max_depth = depth;
   }
 
-  if (da1 + da2 < max_angle_tolerance) {
+  if (da1 + da2 < builder->max_angle_tolerance || span <= fixedpoint_base
+      || depth >= MAX_RECURSION_DEPTH) {
     // Finally we can stop the recursion
-    return gpath_builder_line_to_point(builder, GPoint(x1234 / fixedpoint_base,
-                                                       y1234 / fixedpoint_base));
+    return add_point(builder, GPoint(x1234 / fixedpoint_base, y1234 / fixedpoint_base));
   }
 
   // Continue subdivision if points are being added successfully
-  if (recursive_bezier_fixed(builder, x1, y1, x12, y12, x123, y123, x1234, y1234)
-      && recursive_bezier_fixed(builder, x1234, y1234, x234, y234, x34, y34, x4, y4)) {
+  if (recursive_bezier_fixed(builder, depth + 1, x1, y1, x12, y12, x123, y123, x1234, y1234)
+      && recursive_bezier_fixed(builder, depth + 1, x1234, y1234, x234, y234, x34, y34, x4, y4)) {
     return true;
   }
 
   return false;
 }
 
-bool bezier_fixed(GPathBuilder *builder, GPoint p1, GPoint p2, GPoint p3, GPoint p4) {
+// p1 is the current point, which has been transformed already - the others are transformed on the
+// way into the fixedpoint realm so the curve keeps its sub-pixel precision
+static bool bezier_fixed(GPathBuilder *builder, GPoint p1, GPoint p2, GPoint p3, GPoint p4) {
+  const GPathTransform *t = &builder->transform;
+
   // Translate points to fixedpoint realms
   int32_t x1 = p1.x * fixedpoint_base;
-  int32_t x2 = p2.x * fixedpoint_base;
-  int32_t x3 = p3.x * fixedpoint_base;
-  int32_t x4 = p4.x * fixedpoint_base;
+  int32_t x2 = transform_fixed(p2.x, t->scale_x, t->offset.x);
+  int32_t x3 = transform_fixed(p3.x, t->scale_x, t->offset.x);
+  int32_t x4 = transform_fixed(p4.x, t->scale_x, t->offset.x);
   int32_t y1 = p1.y * fixedpoint_base;
-  int32_t y2 = p2.y * fixedpoint_base;
-  int32_t y3 = p3.y * fixedpoint_base;
-  int32_t y4 = p4.y * fixedpoint_base;
+  int32_t y2 = transform_fixed(p2.y, t->scale_y, t->offset.y);
+  int32_t y3 = transform_fixed(p3.y, t->scale_y, t->offset.y);
+  int32_t y4 = transform_fixed(p4.y, t->scale_y, t->offset.y);
 
-  if (recursive_bezier_fixed(builder, x1, y1, x2, y2, x3, y3, x4, y4)) {
-    return gpath_builder_line_to_point(builder, p4);
+  if (recursive_bezier_fixed(builder, 0, x1, y1, x2, y2, x3, y3, x4, y4)) {
+    return add_point(builder, fixed_to_point(x4, y4));
   }
   return false;
 }
@@ -85,14 +129,56 @@ GPathBuilder *gpath_builder_create(uint32_t max_points) {
 
   memset(result, 0, required_size);
   result->max_points = max_points;
+  result->transform = GPathTransformIdentity;
+  result->max_angle_tolerance = max_angle_tolerance;
+  return result;
+}
+
+GPathBuilder *gpath_builder_create_counter(void) {
+  // No room for any points - add_point only counts them
+  GPathBuilder *result = gpath_builder_create(0);
+
+  if (result) {
+    result->count_only = true;
+  }
   return result;
 }
 
+void gpath_builder_set_transform(GPathBuilder *builder, GPathTransform transform) {
+  builder->transform = transform;
+}
+
+void gpath_builder_set_tolerance(GPathBuilder *builder, int32_t degrees) {
+  builder->max_angle_tolerance = (TRIG_MAX_ANGLE / 360) * degrees;
+}
+
 void gpath_builder_destroy(GPathBuilder *builder) {
   free(builder);
 }
 
+// Allocate enough memory for both the GPath structure as well as the array of GPoints.
+// Both will be contiguous in memory.
+static GPath *heap_allocator(uint32_t num_points, void *context) {
+  GPath *result = malloc(sizeof(GPath) + num_points * sizeof(GPoint));
+
+  if (!result) {
+    return NULL;
+  }
+
+  memset(result, 0, sizeof(GPath));
+  result->num_points = num_points;
+  // Set the points pointer within the GPath structure to point just after the GPath structure
+  // since that is where memory has been allocated for the array.
+  result->points = (GPoint*)(result + 1);
+  return result;
+}
+
 GPath *gpath_builder_create_path(GPathBuilder *builder) {
+  return gpath_builder_create_path_with(builder, heap_allocator, NULL);
+}
+
+GPath *gpath_builder_create_path_with(GPathBuilder *builder, GPathAllocator allocator,
+                                      void *context) {
   if (builder->num_points <= 1) {
     return NULL;
   }
@@ -101,25 +187,17 @@ GPath *gpath_builder_create_path(GPathBuilder *builder) {
 
   // handle case where last point == first point => remove last point
   while (num_points > 1
-          && gpoint_equal(&builder->points[0], &builder->points[num_points])) {
+          && gpoint_equal(&builder->points[0], &builder->points[num_points - 1])) {
     num_points--;
   }
 
-  // Allocate enough memory for both the GPath structure as well as the array of GPoints.
-  // Both will be contiguous in memory.
-  const size_t size_of_points = num_points * sizeof(GPoint);
-  GPath *result = malloc(sizeof(GPath) + size_of_points);
+  GPath *result = allocator(num_points, context);
 
   if (!result) {
     return NULL;
   }
 
-  memset(result, 0, sizeof(GPath));
-  result->num_points = num_points;
-  // Set the points pointer within the GPath structure to point just after the GPath structure
-  // since that is where memory has been allocated for the array.
-  result->points = (GPoint*)(result + 1);
-  memcpy(result->points, builder->points, size_of_points);
+  memcpy(result->points, builder->points, num_points * sizeof(GPoint));
   return result;
 }
 
@@ -131,17 +209,33 @@ bool gpath_builder_move_to_point(GPathBuilder *builder, GPoint to_point) {
   return gpath_builder_line_to_point(builder, to_point);
 }
 
-bool gpath_builder_line_to_point(GPathBuilder *builder, GPoint to_point) {
-  if (builder->num_points >= builder->max_points - 1) {
+// Adds a point that is already transformed
+static bool add_point(GPathBuilder *builder, GPoint to_point) {
+  if (builder->count_only) {
+    builder->num_points++;
+    builder->current_point = to_point;
+    return true;
+  }
+
+  if (builder->num_points >= builder->max_points) {
+    builder->overflowed = true;
     return false;
   }
 
   builder->points[builder->num_points++] = to_point;
+  builder->current_point = to_point;
   return true;
 }
 
+bool gpath_builder_line_to_point(GPathBuilder *builder, GPoint to_point) {
+  return add_point(builder, gpath_transform_point(&builder->transform, to_point));
+}
+
 bool gpath_builder_curve_to_point(GPathBuilder *builder, GPoint to_point,
                                   GPoint control_point_1, GPoint control_point_2) {
-  GPoint from_point = builder->points[builder->num_points-1];
-  return bezier_fixed(builder, from_point, control_point_1, control_point_2, to_point);
+  if (builder->num_points == 0) {
+    return false;
+  }
+
+  return bezier_fixed(builder, builder->current_point, control_point_1, control_point_2, to_point);
 }
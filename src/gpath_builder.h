@@ -38,6 +38,24 @@
 //! \endcode
 //!   @{
 
+//! Fixed-point value of a 1:1 scale in GPathTransform
+#define GPATH_TRANSFORM_ONE (1 << 12)
+
+//! Scale and translation applied to every point given to a GPathBuilder, so that paths designed
+//! for one screen can be built for another. Bezier curves are unchanged in shape by scaling, so
+//! control points are transformed before flattening and no precision is lost.
+typedef struct {
+  //! Horizontal scale, where GPATH_TRANSFORM_ONE is 1:1
+  int32_t scale_x;
+  //! Vertical scale, where GPATH_TRANSFORM_ONE is 1:1
+  int32_t scale_y;
+  //! Offset added after scaling
+  GPoint offset;
+} GPathTransform;
+
+//! The transform that leaves points where they are
+#define GPathTransformIdentity ((GPathTransform) { GPATH_TRANSFORM_ONE, GPATH_TRANSFORM_ONE, { 0, 0 } })
+
 //! Data structure used by gpath builder
 //! @note This structure is being filled by gpath builder
 typedef struct {
@@ -45,6 +63,18 @@ typedef struct {
   uint32_t max_points;
   //! The number of points in `points` array
   uint32_t num_points;
+  //! Transform applied to points as they are added, identity by default
+  GPathTransform transform;
+  //! Curves are subdivided until their turn is below this angle (TRIG_MAX_ANGLE units)
+  int32_t max_angle_tolerance;
+  //! True for a builder made by gpath_builder_create_counter(), which stores no points
+  bool count_only;
+  //! Set when a point didn't fit in `points` - the path built from it will be incomplete
+  bool overflowed;
+  //! The deepest any curve has been subdivided, for checking degenerate curves stay bounded
+  uint8_t max_depth;
+  //! The last point added, where the next line or curve starts from
+  GPoint current_point;
   //! Array containing points
   GPoint points[];
 } GPathBuilder;
@@ -56,9 +86,31 @@ typedef struct {
 //! @return A pointer to GPathBuilder. NULL if object couldnt be created
 GPathBuilder *gpath_builder_create(uint32_t max_points);
 
+//! Creates a GPathBuilder that flattens exactly as a normal one does but stores no points, so
+//! afterwards `num_points` is the exact number a real builder would need for the same calls
+//!
+//! @return A pointer to GPathBuilder. NULL if object couldnt be created
+GPathBuilder *gpath_builder_create_counter(void);
+
 //! Destroys GPathBuilder previously created with gpath_builder_create()
 void gpath_builder_destroy(GPathBuilder *builder);
 
+//! Sets the transform applied to every point added after this call
+//! @param builder GPathBuilder object to manipulate on
+//! @param transform scale & offset to apply
+void gpath_builder_set_transform(GPathBuilder *builder, GPathTransform transform);
+
+//! Sets how finely curves added after this call are flattened - larger angles give fewer points
+//! @param builder GPathBuilder object to manipulate on
+//! @param degrees angle below which a curve segment is treated as straight (10 by default)
+void gpath_builder_set_tolerance(GPathBuilder *builder, int32_t degrees);
+
+//! Applies a transform to a single point, rounding to the nearest pixel
+//! @param transform scale & offset to apply
+//! @param point point to transform
+//! @return The transformed point
+GPoint gpath_transform_point(const GPathTransform *transform, GPoint point);
+
 //! Sets starting point for GPath
 //! @param builder GPathBuilder object to manipulate on
 //! @param to_point starting point for the GPath
@@ -69,7 +121,8 @@ bool gpath_builder_move_to_point(GPathBuilder *builder, GPoint to_point);
 //! Makes straight line from current point to point given and makes it new current point
 //! @param builder GPathBuilder object to manipulate on
 //! @param to_point ending point for the line
-//! @return True if line was added successfully False if there was no space in GPathBuilder struct
+//! @return True if line was added successfully False if there was no space in GPathBuilder struct,
+//! in which case `overflowed` is set
 bool gpath_builder_line_to_point(GPathBuilder *builder, GPoint to_point);
 
 //! Makes bezier curve from current point to point given and makes it new current point,
@@ -78,7 +131,8 @@ bool gpath_builder_line_to_point(GPathBuilder *builder, GPoint to_point);
 //! @param to_point ending point for bezier curve
 //! @param control_point_1 control point for start of the bezier curve
 //! @param control_point_2 control point for end of the bezier curve
-//! @return True if curve was added successfully False if there was no space in GPathBuilder struct
+//! @return True if curve was added successfully False if there was no space in GPathBuilder struct,
+//! in which case `overflowed` is set, or there is no current point to start from
 bool gpath_builder_curve_to_point(GPathBuilder *builder, GPoint to_point,
                                   GPoint control_point_1, GPoint control_point_2);
 
@@ -91,5 +145,22 @@ bool gpath_builder_curve_to_point(GPathBuilder *builder, GPoint to_point,
 //! @return A pointer to the GPath. `NULL` if num_points less than 2 or not enough memory
 GPath *gpath_builder_create_path(GPathBuilder *builder);
 
+//! Allocates a GPath with `num_points` points ready to be filled in, for
+//! gpath_builder_create_path_with()
+//! @param num_points number of points the GPath needs room for
+//! @param context the context given to gpath_builder_create_path_with()
+//! @return A GPath with `num_points` and `points` set up, NULL if there's not enough memory
+typedef GPath *(*GPathAllocator)(uint32_t num_points, void *context);
+
+//! As gpath_builder_create_path(), but the GPath comes from the given allocator rather than
+//! straight from the heap - it must be released however the allocator expects, not with
+//! gpath_destroy()
+//! @param builder GPathBuilder object holding the points
+//! @param allocator function to allocate the GPath
+//! @param context passed through to `allocator`
+//! @return A pointer to the GPath. `NULL` if num_points less than 2 or not enough memory
+GPath *gpath_builder_create_path_with(GPathBuilder *builder, GPathAllocator allocator,
+                                      void *context);
+
 //!   @} // end addtogroup PathBuilding
 //! @} // end addtogroup Graphics
@@ -1,47 +1,140 @@
 #include <pebble.h>
 #include "gpath_builder.h"
 #include "draw_layers.h"
+#include "name_index.h"
+#include "catalog_sync.h"
 
 /********************************************/
 /*************** DECLARATIONS ***************/
 /********************************************/
 	
 /* declaration of variable "objects" */
-static Window *graphicWindow, *detailWindow;
-static TextLayer *graphicHeader[2], *detailHeader, *detailText;
+static Window *graphicWindow, *detailWindow, *gridWindow, *letterWindow;
+static TextLayer *graphicHeader[2], *detailHeader, *detailText, *gridHeader;
+static TextLayer *letterHeader, *letterText, *letterName;
+static Layer *gridLayer;
 static Layer *actionBarLayer[2];
 static Layer *actionBarIconGraphic[3];
 static Layer *actionBarIconDetail;
+static Layer *actionBarIconScroll[2];
 static Layer *graphicDrawLayer[2];
 static Layer *graphicBackgroundLayer;
+static Layer *graphicCupLayer;
 static PropertyAnimation *animations[3];
+static Animation *pourAnimation;
+static Layer *pourLayer;
+static AppTimer *prefetchTimer;
+static AppTimer *stagingTimer;
+static bool prefetchPending = false;
+static bool maskShowing = false;
+static int skippedPaints = 0;
+static bool previewing = false;
+#if DRAW_TIMING
+static int tierPaints[2];
+static int tierMillis[2];
+#endif
+static int transitionFrames = 0;
+static uint32_t lastTransitionTime = 0;
+static int transitionStyle;
+static bool transitionLogPending = false;
+static Animation *steppedAnimation;
+
+/* the transition under way - the animation whose stop ends it, and where its layers are headed */
+static Animation *transitionAnimation;
+static Layer *transitionLayers[3];
+static GRect transitionTo[3];
+static Layer *steppedLayers[3];
+static GRect steppedFrom[3], steppedTo[3];
+static int steppedFrame;
 
 /* declaration of variables */
 static int active = 0;
 static int drawingItem[2];
+static int gridSelected = 0;
+static int gridTopRow = 0;
+static int letterBucket = 0;
+static char letterLabel[2];
+
+/* the synced drink showing when a sync started, by name, to go back to once the sync has stored it again - empty
+   if a built in drink was showing */
+static char syncShowing[SYNC_NAME_MAX + 1];
+
+/* detail text laid out once per drink - where each page starts in the text, a page being the whole words that
+   fit in the view, plus where the last one ends. Only the page showing is given to the text layer, so the rest
+   of the text is never laid out; no pages means not measured yet */
+#define DETAIL_MAX_PAGES 8
+typedef struct {
+	uint16_t pageStart[DETAIL_MAX_PAGES + 1];
+	uint8_t pages;
+} DetailLayout;
+static DetailLayout *detailLayouts;
+static DetailLayout detailLayout;
+static int detailPage;
+static const char *detailFullText;
+static char *detailPageText;
+static bool firstFramePending = true;
+#if DRAW_TIMING
+static time_t startSeconds = 0;
+static uint16_t startMillis = 0;
+#endif
 
 /* declaration of constants with #define statements */
-#define BG_COLOUR GColorDarkGray
+#define BG_COLOUR COLOR_FALLBACK(GColorDarkGray, GColorBlack)
 #define TEXT_COLOUR GColorWhite
 #define BAR_BG_COLOUR GColorBlack
 #define ICON_COLOUR GColorWhite
-#define SCREEN_HEIGHT 168
-#define HEADER_HEIGHT 27
-#define DETAIL_OFFSET 3
+#define SCREEN_WIDTH PBL_IF_ROUND_ELSE(180, 144)
+#define SCREEN_HEIGHT PBL_IF_ROUND_ELSE(180, 168)
+/* on round screens the header drops below the curve of the top edge, and the bar & drawings come in from the
+   sides, where the screen is narrower */
+#define HEADER_TOP PBL_IF_ROUND_ELSE(18, 0)
+#define HEADER_TEXT_HEIGHT 27
+#define HEADER_HEIGHT (HEADER_TOP + HEADER_TEXT_HEIGHT)
+#define DETAIL_OFFSET PBL_IF_ROUND_ELSE(12, 3)
 #define DETAIL_SPACE 5
-#define BAR_WIDTH 15
-#define BAR_SPACE 10
+#define DETAIL_MAX_HEIGHT 2000
+#define BAR_WIDTH PBL_IF_ROUND_ELSE(21, 15)
+#define BAR_SPACE PBL_IF_ROUND_ELSE(55, 10)
 #define BAR_ROUNDING 3
 #define TRIANGLE_BASE 11
 #define TRIANGLE_HEIGHT 6
 #define ICON_SPACE 7
-#define HEADER_WIDTH 144 - BAR_WIDTH
+#define HEADER_WIDTH PBL_IF_ROUND_ELSE(SCREEN_WIDTH, SCREEN_WIDTH - BAR_WIDTH)
 #define LAYER 0
 #define HEADER 1
 #define BACKGROUND 2
+#define TRANSITION_FULL 0
+#define TRANSITION_REDUCED 1
+#define TRANSITION_CUT 2
 #define ANIMATION_SPEED 500
+#define POUR_SPEED 500
+#define PREFETCH_DELAY 300
+
+/* only the first frame's layers are made as the graphic window loads, and the rest once it's up - set to 0 to
+   make them all up front, for comparing the two (make -C tools/host launch) */
+#ifndef STAGED_LAUNCH
+#define STAGED_LAUNCH 1
+#endif
+
+/* transition governor - picks how to transition from the battery and how fast buttons are being pressed; set
+   TRANSITION_GOVERNOR to 0 to always animate fully */
+#define TRANSITION_GOVERNOR 1
+#define GOVERNOR_LOW_BATTERY 20
+#define GOVERNOR_MID_BATTERY 50
+#define GOVERNOR_RAPID_INPUT 400
+#define GOVERNOR_STEADY_INPUT 1000
+#define REDUCED_FRAMES 8
 #define HEADER_FONT FONT_KEY_GOTHIC_24_BOLD
 #define DETAIL_FONT FONT_KEY_GOTHIC_18
+#define GRID_COLUMNS 3
+#define GRID_CELL_HEIGHT 56
+#define GRID_CELL_SPACE 2
+#define GRID_SELECT_COLOUR GColorWhite
+#define LETTER_FONT FONT_KEY_BITHAM_42_BOLD
+#define LETTER_HEIGHT 50
+
+/* persistent storage keys - src/draw_layers.c uses 10 onwards and src/catalog_sync.c 20 onwards */
+#define PERSIST_KEY_LAST_ITEM 1
 
 /* declarations for functions which are implemented below (for improved code legibility) */
 static TextLayer* get_header_layer();
@@ -55,11 +148,29 @@ static void draw_arrow_right(Layer *l, GContext *ctx);
 static void format_header_layer(TextLayer *t);
 static void detail_window_push();
 static void detail_window_pop();
+static void grid_window_push();
+static void grid_window_pop();
+static void letter_window_push();
+static void letter_window_pop();
+static void graphic_window_jump_to(int item);
+static void finish_transition();
+static void log_transition_stats();
 static void update_layer_1_proc(Layer *l, GContext *ctx);
 static void update_layer_2_proc(Layer *l, GContext *ctx);
+static void update_cup_layer_proc(Layer *l, GContext *ctx);
 static void move_layer_above_screen(Layer *l);
 static void move_layer_below_screen(Layer *l);
 static void background_update_proc(Layer *l, GContext *ctx);
+static void start_pour_animation(int layer);
+static void schedule_prefetch();
+static void cancel_prefetch();
+static void paint_draw_layer(Layer *l, GContext *ctx, int layer);
+static Layer* get_draw_layer(int layer);
+static void build_transition_layers();
+static DetailLayout get_detail_layout(int item, const char *text, GSize view);
+static void show_detail_page(int page);
+static int choose_transition_style();
+static void start_stepped_animation(Layer *moving[3], GRect to[3]);
 
 /********************************************/
 /***** CLICK HANDLERS FOR DETAIL WINDOW *****/
@@ -75,10 +186,28 @@ static void detail_window_back_handler(ClickRecognizerRef recogniser, void *cont
 	detail_window_pop();
 }
 
+/* click handlers for the detail window, up & down buttons - turn the text a page at a time */
+static void detail_window_turn(int pages) {
+	int page = detailPage + pages;
+	if (page >= 0 && page < detailLayout.pages) {
+		show_detail_page(page);
+	}
+}
+
+static void detail_window_up_handler(ClickRecognizerRef recogniser, void *context) {
+	detail_window_turn(-1);
+}
+
+static void detail_window_down_handler(ClickRecognizerRef recogniser, void *context) {
+	detail_window_turn(1);
+}
+
 /* click config for the detail window */
 static void detail_window_click_config(void *data) {
 	window_single_click_subscribe(BUTTON_ID_SELECT, detail_window_select_handler);
 	window_single_click_subscribe(BUTTON_ID_BACK, detail_window_back_handler);
+	window_single_click_subscribe(BUTTON_ID_UP, detail_window_up_handler);
+	window_single_click_subscribe(BUTTON_ID_DOWN, detail_window_down_handler);
 }
 
 /* pop the detail window off the stack, revealing graphic window */
@@ -91,15 +220,37 @@ static void detail_window_pop() {
 /**** CLICK HANDLERS FOR GRAPHIC WINDOW *****/
 /********************************************/
 
-/* called when animations end - remove "covered" layers and switch active */
+/* called when animations end - remove "covered" layers and switch active. A stop from any animation but the
+   current transition's is stale (it was stopped by finish_transition, or the window going) and is ignored */
 static void layer_animation_ended(Animation *animation, bool finished, void *data) {
+	if (animation && animation != transitionAnimation) {
+		return;
+	}
+	transitionAnimation = NULL;
+	for (int i = 0; i < 3; i++) {
+		animations[i] = NULL;
+	}
+	
 	/* we assume at this point that our animations are ALL done */
 	layer_remove_from_parent(graphicDrawLayer[active]);
 	layer_remove_from_parent(text_layer_get_layer(graphicHeader[active]));
 	layer_remove_from_parent(graphicBackgroundLayer);
+	maskShowing = false;
+	steppedAnimation = NULL;
+	
+	/* the stats are logged once the settled repaint below has been counted - a cut has no other frames */
+	transitionLogPending = true;
 	
 	/* switch active */
 	active = 1 - active;
+	
+	/* the drawing has stopped moving - one repaint at full quality */
+	previewing = false;
+	set_graphics_quality(QUALITY_FULL);
+	layer_mark_dirty(graphicDrawLayer[active]);
+	
+	/* things have settled - get the neighbours ready */
+	schedule_prefetch();
 }
 
 /* preps for animations and schedules them */
@@ -110,9 +261,18 @@ static void set_for_animation() {
 	/* add layers to window */
 	Layer *w = window_get_root_layer(graphicWindow);
 	layer_add_child(w, graphicBackgroundLayer);
+	maskShowing = true;
+	
+	/* paint cheaply while things are moving */
+	previewing = true;
+	set_graphics_quality(QUALITY_PREVIEW);
 	layer_add_child(w, graphicDrawLayer[inactive]);
 	layer_add_child(w, text_layer_get_layer(graphicHeader[inactive]));
 	
+	/* keep the cup on top - the contents slide in underneath it */
+	layer_remove_from_parent(graphicCupLayer);
+	layer_insert_above_sibling(graphicCupLayer, graphicDrawLayer[inactive]);
+	
 	/* set the 'to' frame for background layer */
 	int width = layer_get_frame(w).size.w - BAR_WIDTH;
 	int height = layer_get_frame(w).size.h;
@@ -124,7 +284,34 @@ static void set_for_animation() {
 	GRect layerTo = GRect(DETAIL_OFFSET, HEADER_HEIGHT + DETAIL_SPACE, width, height);
 	
 	/* set the 'to' frame for header*/
-	GRect headerTo = GRect(0,0,HEADER_WIDTH,HEADER_HEIGHT);
+	GRect headerTo = GRect(0,HEADER_TOP,HEADER_WIDTH,HEADER_TEXT_HEIGHT);
+	
+	Layer *moving[3];
+	GRect to[3];
+	moving[BACKGROUND] = graphicBackgroundLayer;
+	moving[LAYER] = graphicDrawLayer[inactive];
+	moving[HEADER] = text_layer_get_layer(graphicHeader[inactive]);
+	to[BACKGROUND] = backgroundTo;
+	to[LAYER] = layerTo;
+	to[HEADER] = headerTo;
+	
+	for (int i = 0; i < 3; i++) {
+		transitionLayers[i] = moving[i];
+		transitionTo[i] = to[i];
+	}
+	transitionStyle = choose_transition_style();
+	if (transitionStyle == TRANSITION_CUT) {
+		/* straight to the end - one repaint, at full quality */
+		for (int i = 0; i < 3; i++) {
+			layer_set_frame(moving[i], to[i]);
+		}
+		layer_animation_ended(NULL, true, NULL);
+		return;
+	}
+	if (transitionStyle == TRANSITION_REDUCED) {
+		start_stepped_animation(moving, to);
+		return;
+	}
 	
 	/* set layer frames */
 	animations[BACKGROUND] = property_animation_create_layer_frame(graphicBackgroundLayer, NULL, &backgroundTo);
@@ -141,6 +328,7 @@ static void set_for_animation() {
 		.started = (AnimationStartedHandler) NULL,
 		.stopped = (AnimationStoppedHandler) layer_animation_ended,
 	}, NULL);
+	transitionAnimation = (Animation *)animations[LAYER];
 	
 	/* scheduled animations */
 	animation_schedule((Animation *)animations[BACKGROUND]);
@@ -150,11 +338,19 @@ static void set_for_animation() {
 
 /* specific preparation after pushing the "up" button before handing off to set_for_animation */
 static void push_graphic_window_up() {
+	/* the user is doing something - go on from the end of any transition */
+	finish_transition();
+	build_transition_layers();
+	
 	/* calculate inactive layer */
 	int inactive = 1 - active;
 	
-	/* get number of next item up and assign */
+	/* get number of next item up and assign, pour it if we haven't seen it before */
 	drawingItem[inactive] = next_up(drawingItem[active]);
+	start_pour_animation(inactive);
+	
+	/* and don't prefetch underneath them - after the pour, as cutting one short stops it */
+	cancel_prefetch();
 	
 	/* change the text on the header */
 	text_layer_set_text(graphicHeader[inactive], header_text(drawingItem[inactive]));
@@ -170,11 +366,19 @@ static void push_graphic_window_up() {
 
 /* specific preparation after pushing the "down" button before handing off to set_for_animation */
 static void push_graphic_window_down() {
+	/* the user is doing something - go on from the end of any transition */
+	finish_transition();
+	build_transition_layers();
+	
 	/* calculate inactive layer */
 	int inactive = 1 - active;
 	
-	/* get number of next item down and assign */
+	/* get number of next item down and assign, pour it if we haven't seen it before */
 	drawingItem[inactive] = next_down(drawingItem[active]);
+	start_pour_animation(inactive);
+	
+	/* and don't prefetch underneath them - after the pour, as cutting one short stops it */
+	cancel_prefetch();
 	
 	/* change the text on the header */
 	text_layer_set_text(graphicHeader[inactive], header_text(drawingItem[inactive]));
@@ -190,14 +394,29 @@ static void push_graphic_window_down() {
 
 /* graphic window select handler - call "detail window push" */
 static void graphic_window_select_handler(ClickRecognizerRef recogniser, void *context) {
+	cancel_prefetch();
 	detail_window_push();
 }
 
+/* graphic window long up handler - call "grid window push" */
+static void graphic_window_long_up_handler(ClickRecognizerRef recogniser, void *context) {
+	cancel_prefetch();
+	grid_window_push();
+}
+
+/* graphic window long select handler - call "letter window push" */
+static void graphic_window_long_select_handler(ClickRecognizerRef recogniser, void *context) {
+	cancel_prefetch();
+	letter_window_push();
+}
+
 /* graphic window click config provider */
 static void graphic_window_click_config(void *data) {
 	window_single_click_subscribe(BUTTON_ID_SELECT, graphic_window_select_handler);
 	window_single_click_subscribe(BUTTON_ID_UP, push_graphic_window_up);
 	window_single_click_subscribe(BUTTON_ID_DOWN, push_graphic_window_down);
+	window_long_click_subscribe(BUTTON_ID_UP, 0, graphic_window_long_up_handler, NULL);
+	window_long_click_subscribe(BUTTON_ID_SELECT, 0, graphic_window_long_select_handler, NULL);
 }
 
 /********************************************/
@@ -217,11 +436,13 @@ static void detail_window_load(Window *window) {
 	text_layer_set_text(detailHeader, header_text(drawingItem[active]));
 	layer_add_child(w, text_layer_get_layer(detailHeader));
 	
-	/* make detailed textLayer - will abstract this later */
+	/* make detailed textLayer the size of the view - it's given a page of the text at a time */
 	int width = layer_get_frame(w).size.w - BAR_WIDTH - 2 * DETAIL_OFFSET;
 	int height = layer_get_frame(w).size.h - HEADER_HEIGHT - DETAIL_SPACE - DETAIL_OFFSET;
+	detailFullText = detail_text(drawingItem[active]);
+	detailLayout = get_detail_layout(drawingItem[active], detailFullText, GSize(width, height));
+	detailPageText = malloc(strlen(detailFullText) + 1);
 	detailText = text_layer_create(GRect(DETAIL_OFFSET, HEADER_HEIGHT + DETAIL_SPACE, width, height));
-	text_layer_set_text(detailText, detail_text(drawingItem[active]));
 	text_layer_set_background_color(detailText, GColorClear);
 	text_layer_set_text_color(detailText, TEXT_COLOUR);
 	text_layer_set_font(detailText, fonts_get_system_font(DETAIL_FONT));
@@ -236,6 +457,16 @@ static void detail_window_load(Window *window) {
 	layer_set_update_proc(actionBarIconDetail, draw_arrow_left);
 	layer_add_child(w, actionBarIconDetail);
 	
+	/* and the page arrows, shown when there's a page before or after */
+	actionBarIconScroll[0] = get_icon_layer(window, 0);
+	actionBarIconScroll[1] = get_icon_layer(window, 2);
+	layer_set_update_proc(actionBarIconScroll[0], draw_arrow_up);
+	layer_set_update_proc(actionBarIconScroll[1], draw_arrow_down);
+	for (int i = 0; i < 2; i++) {
+		layer_add_child(w, actionBarIconScroll[i]);
+	}
+	show_detail_page(0);
+	
 	/* add click config to window */
 	window_set_click_config_provider(window, (ClickConfigProvider)detail_window_click_config);
 }
@@ -244,8 +475,14 @@ static void detail_window_load(Window *window) {
 static void detail_window_unload(Window *window) {
 	text_layer_destroy(detailHeader);
 	text_layer_destroy(detailText);
+	free(detailPageText);
+	detailPageText = NULL;
+	release_detail_text();
 	layer_destroy(actionBarLayer[1]);
 	layer_destroy(actionBarIconDetail);
+	for (int i = 0; i < 2; i++) {
+		layer_destroy(actionBarIconScroll[i]);
+	}
 }
 
 /* detail window push - create detail window, set handlers, push to stack */
@@ -258,6 +495,250 @@ static void detail_window_push() {
 	window_stack_push(detailWindow, true);
 }
 
+/********************************************/
+/****** CLICK HANDLERS FOR GRID WINDOW ******/
+/********************************************/
+
+/* move the grid selection, scrolling so the selected row stays in view */
+static void grid_move_selection(int delta) {
+	int count = entry_count();
+	gridSelected = (gridSelected + delta + count) % count;
+	
+	int row = gridSelected / GRID_COLUMNS;
+	int visibleRows = layer_get_frame(gridLayer).size.h / GRID_CELL_HEIGHT;
+	if (row < gridTopRow) {
+		gridTopRow = row;
+	} else if (row >= gridTopRow + visibleRows) {
+		gridTopRow = row - visibleRows + 1;
+	}
+	
+	text_layer_set_text(gridHeader, header_text(gridSelected));
+	layer_mark_dirty(gridLayer);
+}
+
+static void grid_window_up_handler(ClickRecognizerRef recogniser, void *context) {
+	grid_move_selection(-1);
+}
+
+static void grid_window_down_handler(ClickRecognizerRef recogniser, void *context) {
+	grid_move_selection(1);
+}
+
+/* grid window select handler - show the selected drink in the graphic window */
+static void grid_window_select_handler(ClickRecognizerRef recogniser, void *context) {
+	graphic_window_jump_to(gridSelected);
+	grid_window_pop();
+}
+
+/* grid window back handler - call the pop routine */
+static void grid_window_back_handler(ClickRecognizerRef recogniser, void *context) {
+	grid_window_pop();
+}
+
+/* click config for the grid window */
+static void grid_window_click_config(void *data) {
+	window_single_repeating_click_subscribe(BUTTON_ID_UP, 100, grid_window_up_handler);
+	window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 100, grid_window_down_handler);
+	window_single_click_subscribe(BUTTON_ID_SELECT, grid_window_select_handler);
+	window_single_click_subscribe(BUTTON_ID_BACK, grid_window_back_handler);
+}
+
+/********************************************/
+/*********** GRID WINDOW HANDLERS ***********/
+/********************************************/
+
+/* the grid - every drink as a thumbnail, which is rendered once and blitted from then on */
+static void grid_update_proc(Layer *l, GContext *ctx) {
+	GRect bounds = layer_get_bounds(l);
+	GPoint origin = layer_get_frame(l).origin;
+	int cellWidth = bounds.size.w / GRID_COLUMNS;
+	
+	graphics_context_set_fill_color(ctx, BG_COLOUR);
+	graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+	
+	for (int i = gridTopRow * GRID_COLUMNS; i < entry_count(); i++) {
+		int row = i / GRID_COLUMNS - gridTopRow;
+		GRect cell = GRect((i % GRID_COLUMNS) * cellWidth, row * GRID_CELL_HEIGHT, cellWidth, GRID_CELL_HEIGHT);
+		if (cell.origin.y >= bounds.size.h) {
+			break;
+		}
+		
+		GRect thumbnail = GRect(cell.origin.x + GRID_CELL_SPACE, cell.origin.y + GRID_CELL_SPACE,
+				cell.size.w - 2 * GRID_CELL_SPACE, cell.size.h - 2 * GRID_CELL_SPACE);
+		draw_thumbnail(i, ctx, thumbnail, origin);
+		
+		if (i == gridSelected) {
+			graphics_context_set_stroke_color(ctx, GRID_SELECT_COLOUR);
+			graphics_context_set_stroke_width(ctx, 1);
+			graphics_draw_rect(ctx, cell);
+		}
+	}
+}
+
+/* grid window load handler */
+static void grid_window_load(Window *window) {
+	Layer *w = window_get_root_layer(window);
+	window_set_background_color(window, BG_COLOUR);
+	
+	/* header shows the name of the selected drink */
+	gridHeader = text_layer_create(GRect(0, HEADER_TOP, layer_get_frame(w).size.w, HEADER_TEXT_HEIGHT));
+	format_header_layer(gridHeader);
+	text_layer_set_text(gridHeader, header_text(gridSelected));
+	layer_add_child(w, text_layer_get_layer(gridHeader));
+	
+	/* the grid fills the rest of the window */
+	int width = layer_get_frame(w).size.w;
+	int height = layer_get_frame(w).size.h - HEADER_HEIGHT;
+	gridLayer = layer_create(GRect(0, HEADER_HEIGHT, width, height));
+	layer_set_update_proc(gridLayer, grid_update_proc);
+	layer_add_child(w, gridLayer);
+	set_thumbnail_size(GSize(width / GRID_COLUMNS - 2 * GRID_CELL_SPACE, GRID_CELL_HEIGHT - 2 * GRID_CELL_SPACE));
+	
+	/* start on the drink that's showing, scrolled so it's in view */
+	grid_move_selection(0);
+	
+	window_set_click_config_provider(window, (ClickConfigProvider)grid_window_click_config);
+}
+
+/* grid window unload handler */
+static void grid_window_unload(Window *window) {
+	text_layer_destroy(gridHeader);
+	layer_destroy(gridLayer);
+	release_thumbnail_paths();
+}
+
+/* grid window push - create grid window, set handlers, push to stack */
+static void grid_window_push() {
+	gridSelected = drawingItem[active];
+	gridWindow = window_create();
+	window_set_window_handlers(gridWindow, (WindowHandlers) {
+		.load = grid_window_load,
+		.unload = grid_window_unload,
+	});
+	window_stack_push(gridWindow, true);
+}
+
+/* pop the grid window off the stack, revealing graphic window */
+static void grid_window_pop() {
+	window_stack_pop(true);
+	window_destroy(gridWindow);
+	gridWindow = NULL;
+}
+
+/********************************************/
+/***** CLICK HANDLERS FOR LETTER WINDOW *****/
+/********************************************/
+
+/* move to the next letter in direction that has any drinks, showing the drink it would jump to */
+static void letter_move_selection(int direction) {
+	int item = -1;
+	for (int i = 0; i < NAME_INDEX_BUCKETS && item < 0; i++) {
+		letterBucket = (letterBucket + direction + NAME_INDEX_BUCKETS) % NAME_INDEX_BUCKETS;
+		item = first_entry_in_bucket(letterBucket);
+		/* standing still only checks the current letter once */
+		if (direction == 0 && item < 0) {
+			direction = 1;
+		}
+	}
+	
+	letterLabel[0] = (letterBucket == NAME_INDEX_OTHER) ? '#' : 'A' + letterBucket;
+	layer_mark_dirty(text_layer_get_layer(letterText));
+	text_layer_set_text(letterName, item >= 0 ? header_text(item) : "");
+}
+
+static void letter_window_up_handler(ClickRecognizerRef recogniser, void *context) {
+	letter_move_selection(-1);
+}
+
+static void letter_window_down_handler(ClickRecognizerRef recogniser, void *context) {
+	letter_move_selection(1);
+}
+
+/* letter window select handler - show the first drink for the letter in the graphic window */
+static void letter_window_select_handler(ClickRecognizerRef recogniser, void *context) {
+	int item = first_entry_in_bucket(letterBucket);
+	if (item >= 0 && item != drawingItem[active]) {
+		graphic_window_jump_to(item);
+	}
+	letter_window_pop();
+}
+
+/* letter window back handler - call the pop routine */
+static void letter_window_back_handler(ClickRecognizerRef recogniser, void *context) {
+	letter_window_pop();
+}
+
+/* click config for the letter window */
+static void letter_window_click_config(void *data) {
+	window_single_repeating_click_subscribe(BUTTON_ID_UP, 100, letter_window_up_handler);
+	window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 100, letter_window_down_handler);
+	window_single_click_subscribe(BUTTON_ID_SELECT, letter_window_select_handler);
+	window_single_click_subscribe(BUTTON_ID_BACK, letter_window_back_handler);
+}
+
+/********************************************/
+/********** LETTER WINDOW HANDLERS **********/
+/********************************************/
+
+/* letter window load handler */
+static void letter_window_load(Window *window) {
+	Layer *w = window_get_root_layer(window);
+	window_set_background_color(window, BG_COLOUR);
+	int width = layer_get_frame(w).size.w;
+	
+	letterHeader = text_layer_create(GRect(0, HEADER_TOP, width, HEADER_TEXT_HEIGHT));
+	format_header_layer(letterHeader);
+	text_layer_set_text(letterHeader, "Jump to");
+	layer_add_child(w, text_layer_get_layer(letterHeader));
+	
+	/* the letter, big, with the drink it goes to underneath */
+	int top = (layer_get_frame(w).size.h - LETTER_HEIGHT) / 2;
+	letterText = text_layer_create(GRect(0, top, width, LETTER_HEIGHT));
+	text_layer_set_text(letterText, letterLabel);
+	text_layer_set_background_color(letterText, GColorClear);
+	text_layer_set_text_color(letterText, TEXT_COLOUR);
+	text_layer_set_font(letterText, fonts_get_system_font(LETTER_FONT));
+	text_layer_set_text_alignment(letterText, GTextAlignmentCenter);
+	layer_add_child(w, text_layer_get_layer(letterText));
+	
+	letterName = text_layer_create(GRect(0, top + LETTER_HEIGHT, width, HEADER_TEXT_HEIGHT));
+	text_layer_set_background_color(letterName, GColorClear);
+	text_layer_set_text_color(letterName, TEXT_COLOUR);
+	text_layer_set_font(letterName, fonts_get_system_font(DETAIL_FONT));
+	text_layer_set_text_alignment(letterName, GTextAlignmentCenter);
+	layer_add_child(w, text_layer_get_layer(letterName));
+	
+	/* start on the letter of the drink that's showing */
+	letterBucket = name_index_bucket(header_text(drawingItem[active])[0]);
+	letter_move_selection(0);
+	
+	window_set_click_config_provider(window, (ClickConfigProvider)letter_window_click_config);
+}
+
+/* letter window unload handler */
+static void letter_window_unload(Window *window) {
+	text_layer_destroy(letterHeader);
+	text_layer_destroy(letterText);
+	text_layer_destroy(letterName);
+}
+
+/* letter window push - create letter window, set handlers, push to stack */
+static void letter_window_push() {
+	letterWindow = window_create();
+	window_set_window_handlers(letterWindow, (WindowHandlers) {
+		.load = letter_window_load,
+		.unload = letter_window_unload,
+	});
+	window_stack_push(letterWindow, true);
+}
+
+/* pop the letter window off the stack, revealing graphic window */
+static void letter_window_pop() {
+	window_stack_pop(true);
+	window_destroy(letterWindow);
+	letterWindow = NULL;
+}
+
 /********************************************/
 /********** GRAPHIC WINDOW HANDLERS *********/
 /********************************************/
@@ -270,9 +751,9 @@ static void graphic_window_load(Window *window) {
 	/* set background colour */
 	window_set_background_color(window, BG_COLOUR);
 	
-	/* get new (formatted) header layers, set text, add the base one to the window */
-	graphicHeader[0] = get_header_layer();
-	graphicHeader[1] = get_header_layer();
+	/* only what's in the first frame is made here - the rest waits for the first transition, or for idle time
+	   once the first frame is up (see build_transition_layers) */
+	graphicHeader[active] = get_header_layer();
 	text_layer_set_text(graphicHeader[active], header_text(drawingItem[active]));
 	layer_add_child(w, text_layer_get_layer(graphicHeader[active]));
 	
@@ -291,36 +772,127 @@ static void graphic_window_load(Window *window) {
 		layer_add_child(w, actionBarIconGraphic[i]);
 	}
 	
-	/* make both draw layers, add the active one */
+	/* make the active draw layer */
 	int width = layer_get_frame(w).size.w - BAR_WIDTH - 2 * DETAIL_OFFSET;
 	int height = layer_get_frame(w).size.h - HEADER_HEIGHT - DETAIL_SPACE - DETAIL_OFFSET;
-	graphicDrawLayer[0] = layer_create(GRect(DETAIL_OFFSET, HEADER_HEIGHT + DETAIL_SPACE, width, height));
-	graphicDrawLayer[1] = layer_create(GRect(DETAIL_OFFSET, HEADER_HEIGHT + DETAIL_SPACE, width, height));
-	layer_set_update_proc(graphicDrawLayer[0], update_layer_1_proc);
-	layer_set_update_proc(graphicDrawLayer[1], update_layer_2_proc);
+	set_graphics_size(GSize(width, height));
+	graphicDrawLayer[active] = get_draw_layer(active);
 	layer_add_child(w, graphicDrawLayer[active]);
+	start_pour_animation(active);
 	
-	/* make (but don't add) the graphic background layer */
-	width = layer_get_frame(w).size.w - BAR_WIDTH;
-	height = layer_get_frame(w).size.h;
-	graphicBackgroundLayer = layer_create(GRect(0,0,width,height));
-	layer_set_update_proc(graphicBackgroundLayer, background_update_proc);
+	/* make the cup layer, which stays put above whichever draw layers are showing */
+	graphicCupLayer = layer_create(GRect(DETAIL_OFFSET, HEADER_HEIGHT + DETAIL_SPACE, width, height));
+	layer_set_update_proc(graphicCupLayer, update_cup_layer_proc);
+	layer_add_child(w, graphicCupLayer);
+	schedule_prefetch();
+#if !STAGED_LAUNCH
+	build_transition_layers();
+#endif
 	
 	/* set click config for window */
 	window_set_click_config_provider(window, (ClickConfigProvider)graphic_window_click_config);
 }
 
+/* show a given drink straight away, without a transition */
+static void graphic_window_jump_to(int item) {
+	finish_transition();
+	drawingItem[active] = item;
+	text_layer_set_text(graphicHeader[active], header_text(item));
+	layer_mark_dirty(graphicDrawLayer[active]);
+	start_pour_animation(active);
+	schedule_prefetch();
+}
+
 /* graphic window unload handler */
 static void graphic_window_unload(Window *window) {
+	if (pourAnimation) {
+		animation_unschedule(pourAnimation);
+	}
+	transitionAnimation = NULL;
+	for (int i = 0; i < 3; i++) {
+		if (animations[i] && animation_is_scheduled((Animation *)animations[i])) {
+			animation_unschedule((Animation *)animations[i]);
+		}
+	}
+	if (steppedAnimation) {
+		animation_unschedule(steppedAnimation);
+	}
+	cancel_prefetch();
+	if (stagingTimer) {
+		app_timer_cancel(stagingTimer);
+		stagingTimer = NULL;
+	}
+	
+	/* the transition layers might never have been made */
 	for (int i = 0; i < 2; i++) {
-		text_layer_destroy(graphicHeader[i]);
-		layer_destroy(graphicDrawLayer[i]);
+		if (graphicHeader[i]) {
+			text_layer_destroy(graphicHeader[i]);
+			graphicHeader[i] = NULL;
+		}
+		if (graphicDrawLayer[i]) {
+			layer_destroy(graphicDrawLayer[i]);
+			graphicDrawLayer[i] = NULL;
+		}
 	}
 	layer_destroy(actionBarLayer[0]);
 	for (int i = 0; i < 3; i++) {
 		layer_destroy(actionBarIconGraphic[i]);
 	}
-	layer_destroy(graphicBackgroundLayer);
+	if (graphicBackgroundLayer) {
+		layer_destroy(graphicBackgroundLayer);
+		graphicBackgroundLayer = NULL;
+	}
+	layer_destroy(graphicCupLayer);
+	
+	/* the window's paths & caches go with it - save the paths for next time first */
+	save_graphics_cache();
+	destroy_graphics_cache();
+}
+
+/********************************************/
+/*************** CATALOG SYNC ***************/
+/********************************************/
+
+/* the grid & letter windows hold on to a drink while they're open, which a sync can take away - move them onto
+   ones that are still there */
+static void keep_pickers_in_catalog() {
+	if (gridSelected >= entry_count()) {
+		gridSelected = entry_count() - 1;
+	}
+	if (gridWindow && window_stack_contains_window(gridWindow)) {
+		grid_move_selection(0);
+	}
+	if (letterWindow && window_stack_contains_window(letterWindow)) {
+		letter_move_selection(0);
+	}
+}
+
+/* the phone is replacing the synced drinks - move off one if it's showing (remembering which), and forget what
+   was cached for them */
+static void catalog_sync_started() {
+	syncShowing[0] = '\0';
+	if (drawingItem[active] >= entry_count() - catalog_sync_count()) {
+		strncpy(syncShowing, header_text(drawingItem[active]), SYNC_NAME_MAX);
+		syncShowing[SYNC_NAME_MAX] = '\0';
+		graphic_window_jump_to(0);
+	}
+	forget_synced_drinks();
+	if (detailLayouts) {
+		memset(detailLayouts, 0, max_entry_count() * sizeof(DetailLayout));
+	}
+	keep_pickers_in_catalog();
+}
+
+/* the new synced drinks are stored - go back to the one that was showing, if the phone sent it again */
+static void catalog_sync_ended() {
+	for (int i = entry_count() - catalog_sync_count(); syncShowing[0] && i < entry_count(); i++) {
+		if (strcmp(header_text(i), syncShowing) == 0) {
+			graphic_window_jump_to(i);
+			break;
+		}
+	}
+	syncShowing[0] = '\0';
+	keep_pickers_in_catalog();
 }
 
 /********************************************/
@@ -328,6 +900,18 @@ static void graphic_window_unload(Window *window) {
 /********************************************/
 
 static void init(void) {
+  /* the drinks synced from the phone come first, so the last one showing can be one of them */
+  catalog_sync_init(catalog_sync_started, catalog_sync_ended);
+
+  /* start on whatever was showing last time */
+  if (persist_exists(PERSIST_KEY_LAST_ITEM)) {
+    int item = persist_read_int(PERSIST_KEY_LAST_ITEM);
+    drawingItem[active] = (item >= 0 && item < entry_count()) ? item : 0;
+  }
+
+  /* long lived, so allocated before anything comes and goes around it */
+  detailLayouts = calloc(max_entry_count(), sizeof(DetailLayout));
+
   graphicWindow = window_create();
   window_set_window_handlers(graphicWindow, (WindowHandlers) {
     .load = graphic_window_load,
@@ -338,9 +922,14 @@ static void init(void) {
 
 static void deinit(void) {
 	window_destroy(graphicWindow);
+	persist_write_int(PERSIST_KEY_LAST_ITEM, drawingItem[active]);
+	free(detailLayouts);
 }
 
 int main(void) {
+#if DRAW_TIMING
+  time_ms(&startSeconds, &startMillis);
+#endif
   init();
   app_event_loop();
   deinit();
@@ -352,7 +941,7 @@ int main(void) {
 
 /* return a header layer, sized and formatted*/
 static TextLayer* get_header_layer() {
-	TextLayer *temp = text_layer_create(GRect(0,0,HEADER_WIDTH,HEADER_HEIGHT));
+	TextLayer *temp = text_layer_create(GRect(0,HEADER_TOP,HEADER_WIDTH,HEADER_TEXT_HEIGHT));
 	format_header_layer(temp);
 	return temp;
 }
@@ -391,60 +980,54 @@ static void draw_action_bar_round_rect(Layer *layer, GContext *ctx) {
 /**** HELPER METHODS - ICONS IN ACTION BAR ****/
 /**********************************************/
 
+/* the arrows are drawn from GPaths on the stack - there's nothing to allocate each paint */
+
 /* draw up arrow as icon in the 'faux' action bar */
 static void draw_arrow_up(Layer *layer, GContext *ctx) {
 	int height = layer_get_frame(layer).size.h;
 	int width = layer_get_frame(layer).size.w;
-	GPathInfo tempPathInfo = {
+	GPath tempPath = {
 		.num_points = 3,
 		.points = (GPoint[]) { {width/2 , 0}, {width, height}, {0, height} }
 	};
-	GPath *tempPath = gpath_create(&tempPathInfo);
 	graphics_context_set_fill_color(ctx, ICON_COLOUR);
-	gpath_draw_filled(ctx, tempPath);
-	gpath_destroy(tempPath);
+	gpath_draw_filled(ctx, &tempPath);
 }
 
 /* draw down arrow as icon in the 'faux' action bar */
 static void draw_arrow_down(Layer *layer, GContext *ctx) {
 	int height = layer_get_frame(layer).size.h;
 	int width = layer_get_frame(layer).size.w;
-	GPathInfo tempPathInfo = {
+	GPath tempPath = {
 		.num_points = 3,
 		.points = (GPoint[]) { {width/2 , height}, {0, 0}, {width, 0} }
 	};
-	GPath *tempPath = gpath_create(&tempPathInfo);
 	graphics_context_set_fill_color(ctx, ICON_COLOUR);
-	gpath_draw_filled(ctx, tempPath);
-	gpath_destroy(tempPath);
+	gpath_draw_filled(ctx, &tempPath);
 }
 
 /* draw right arrow as icon in the 'faux' action bar */
 static void draw_arrow_right(Layer *layer, GContext *ctx) {
 	int height = layer_get_frame(layer).size.h;
 	int width = layer_get_frame(layer).size.w;
-	GPathInfo tempPathInfo = {
+	GPath tempPath = {
 		.num_points = 3,
 		.points = (GPoint[]) { {width, height/2 + 1}, {0, height}, {0, 0} }
 	};
-	GPath *tempPath = gpath_create(&tempPathInfo);
 	graphics_context_set_fill_color(ctx, ICON_COLOUR);
-	gpath_draw_filled(ctx, tempPath);
-	gpath_destroy(tempPath);
+	gpath_draw_filled(ctx, &tempPath);
 }
 
 /* draw left arrow as icon in the 'faux' action bar */
 static void draw_arrow_left(Layer *layer, GContext *ctx) {
 	int height = layer_get_frame(layer).size.h;
 	int width = layer_get_frame(layer).size.w;
-	GPathInfo tempPathInfo = {
+	GPath tempPath = {
 		.num_points = 3,
 		.points = (GPoint[]) { {0 , height/2}, {width,0}, {width, height} }
 	};
-	GPath *tempPath = gpath_create(&tempPathInfo);
 	graphics_context_set_fill_color(ctx, ICON_COLOUR);
-	gpath_draw_filled(ctx, tempPath);
-	gpath_destroy(tempPath);
+	gpath_draw_filled(ctx, &tempPath);
 }
 
 /* returns a layer for an icon on the 'faux' action bar, sized and positioned */
@@ -479,6 +1062,106 @@ static Layer* get_icon_layer(Window *window, int position) {
 	return temp;
 }
 
+/**********************************************/
+/***** HELPER METHODS - DETAIL TEXT LAYOUT ****/
+/**********************************************/
+
+/* the height of text[from..to] laid out in the given width - copied into scratch to end it there */
+static int detail_text_height(char *scratch, const char *text, int from, int to, GFont font, int width) {
+	memcpy(scratch, &text[from], to - from);
+	scratch[to - from] = '\0';
+	return graphics_text_layout_get_content_size(scratch, font, GRect(0, 0, width, DETAIL_MAX_HEIGHT),
+			GTextOverflowModeWordWrap, GTextAlignmentLeft).h;
+}
+
+/* true if a page can end at i - the end of the text, or the space after a word */
+static bool detail_word_end(const char *text, int i, int length) {
+	return i == length || text[i] == ' ';
+}
+
+/* where the page starting at start ends - the most whole words that fit in height, found by halving, and
+   always at least one word so a long word can't stall the paging */
+static int detail_page_end(char *scratch, const char *text, int start, int length, GFont font, GSize view,
+		int height) {
+	int fits = start + 1;
+	while (!detail_word_end(text, fits, length)) {
+		fits++;
+	}
+	int limit = length;
+	while (fits < limit) {
+		int middle = (fits + limit + 1) / 2;
+		int end = middle;
+		while (end > fits && !detail_word_end(text, end, length)) {
+			end--;
+		}
+		if (end == fits) {
+			limit = middle - 1;
+		} else if (detail_text_height(scratch, text, start, end, font, view.w) <= height) {
+			fits = end;
+		} else {
+			limit = end - 1;
+		}
+	}
+	return fits;
+}
+
+/* split text into pages of whole lines for a view of the given size - once there's no room for more pages,
+   or no memory to measure with, the rest goes on the last page */
+static void measure_detail_pages(DetailLayout *layout, const char *text, GSize view) {
+	GFont font = fonts_get_system_font(DETAIL_FONT);
+	int line = graphics_text_layout_get_content_size("X", font, GRect(0, 0, view.w, DETAIL_MAX_HEIGHT),
+			GTextOverflowModeWordWrap, GTextAlignmentLeft).h;
+	int height = (line > 0 && view.h >= line) ? view.h / line * line : view.h;
+	int length = strlen(text);
+	char *scratch = malloc(length + 1);
+	
+	layout->pages = 0;
+	int start = 0;
+	do {
+		layout->pageStart[layout->pages++] = start;
+		if (!scratch || layout->pages == DETAIL_MAX_PAGES || start >= length) {
+			break;
+		}
+		start = detail_page_end(scratch, text, start, length, font, view, height);
+		while (start < length && text[start] == ' ') {
+			start++;
+		}
+	} while (start < length);
+	layout->pageStart[layout->pages] = length;
+	free(scratch);
+}
+
+/* the layout of a drink's detail text in a view of the given size - measured the first time the drink is
+   shown and kept, so re-opening it never lays the text out again */
+static DetailLayout get_detail_layout(int item, const char *text, GSize view) {
+	if (!detailLayouts) {
+		detailLayouts = calloc(max_entry_count(), sizeof(DetailLayout));
+	}
+	DetailLayout measured;
+	DetailLayout *layout = detailLayouts ? &detailLayouts[item] : &measured;
+	if (!detailLayouts || layout->pages == 0) {
+		measure_detail_pages(layout, text, view);
+	}
+	return *layout;
+}
+
+/* show a page of the detail text, and the arrows for the pages either side of it */
+static void show_detail_page(int page) {
+	detailPage = page;
+	int from = detailLayout.pageStart[page];
+	int to = detailLayout.pageStart[page + 1];
+	if (detailPageText) {
+		memcpy(detailPageText, &detailFullText[from], to - from);
+		detailPageText[to - from] = '\0';
+		text_layer_set_text(detailText, detailPageText);
+	} else {
+		/* no room for a copy of the page - show everything from it on, clipped to the view */
+		text_layer_set_text(detailText, &detailFullText[from]);
+	}
+	layer_set_hidden(actionBarIconScroll[0], page == 0);
+	layer_set_hidden(actionBarIconScroll[1], page >= detailLayout.pages - 1);
+}
+
 /**********************************************/
 /*** HELPER METHODS - BACKGROUND DRAW PROC ****/
 /**********************************************/
@@ -491,11 +1174,57 @@ static void background_update_proc(Layer *l, GContext *ctx) {
 	graphics_fill_rect(ctx, GRect(0,0,width,height), 0, GCornerNone);
 }
 
+/**********************************************/
+/*** HELPER METHODS - STAGED LAYER CREATION ***/
+/**********************************************/
+
+/* return a draw layer, sized to sit under the header and painting drawingItem[layer] */
+static Layer* get_draw_layer(int layer) {
+	Layer *w = window_get_root_layer(graphicWindow);
+	int width = layer_get_frame(w).size.w - BAR_WIDTH - 2 * DETAIL_OFFSET;
+	int height = layer_get_frame(w).size.h - HEADER_HEIGHT - DETAIL_SPACE - DETAIL_OFFSET;
+	Layer *temp = layer_create(GRect(DETAIL_OFFSET, HEADER_HEIGHT + DETAIL_SPACE, width, height));
+	layer_set_update_proc(temp, (layer == 0) ? update_layer_1_proc : update_layer_2_proc);
+	return temp;
+}
+
+/* make whatever a transition needs that the first frame didn't - the other header & draw layer, and the
+   background mask; called when a transition starts and from idle time after the first frame, whichever is
+   first (none of them are added to the window here) */
+static void build_transition_layers() {
+	if (stagingTimer) {
+		app_timer_cancel(stagingTimer);
+		stagingTimer = NULL;
+	}
+	
+	for (int i = 0; i < 2; i++) {
+		if (!graphicHeader[i]) {
+			graphicHeader[i] = get_header_layer();
+		}
+		if (!graphicDrawLayer[i]) {
+			graphicDrawLayer[i] = get_draw_layer(i);
+		}
+	}
+	
+	if (!graphicBackgroundLayer) {
+		Layer *w = window_get_root_layer(graphicWindow);
+		int width = layer_get_frame(w).size.w - BAR_WIDTH;
+		int height = layer_get_frame(w).size.h;
+		graphicBackgroundLayer = layer_create(GRect(0,0,width,height));
+		layer_set_update_proc(graphicBackgroundLayer, background_update_proc);
+	}
+}
+
+static void staging_timer_callback(void *data) {
+	stagingTimer = NULL;
+	build_transition_layers();
+}
+
 /**********************************************/
 /*** HELPER METHODS - POSITIONS FOR LAYERS ****/
 /**********************************************/
 
-/* change a layer's frame so it's below the screen (origin.y is >= 168) */
+/* change a layer's frame so it's below the screen (origin.y is >= SCREEN_HEIGHT) */
 static void move_layer_below_screen(Layer *l) {
 	int xPos = layer_get_frame(l).origin.x;
 	int yPos = layer_get_frame(l).origin.y;
@@ -519,14 +1248,292 @@ static void move_layer_above_screen(Layer *l) {
 	layer_set_frame(l, GRect(xPos,yPos,width,height));	
 }
 
+/**********************************************/
+/****** HELPER METHODS - POUR ANIMATION *******/
+/**********************************************/
+
+/* each frame of the pour only moves the liquid levels - the cup & handle are replayed from cache */
+static void pour_animation_update(Animation *animation, const AnimationProgress progress) {
+	set_pour_progress(progress);
+	layer_mark_dirty(pourLayer);
+}
+
+/* pour finished (or cut short) - one last repaint with the settled drink. Things have only settled if it ran to
+   the end with nothing sliding; a pour cut short by a press, or one ending mid-transition, leaves the prefetch to
+   whatever comes next */
+static void pour_animation_stopped(Animation *animation, bool finished, void *data) {
+	end_pour();
+	layer_mark_dirty(pourLayer);
+	pourAnimation = NULL;
+	if (finished && !maskShowing) {
+		schedule_prefetch();
+	}
+}
+
+static const AnimationImplementation pourImplementation = {
+	.update = pour_animation_update,
+};
+
+/* pour the drink on a draw layer, if it's the first time the drink has appeared */
+static void start_pour_animation(int layer) {
+	/* only one pour at a time - finish off any pour still running */
+	if (pourAnimation) {
+		animation_unschedule(pourAnimation);
+	}
+	if (!start_pour(drawingItem[layer])) {
+		return;
+	}
+	
+	pourLayer = graphicDrawLayer[layer];
+	pourAnimation = animation_create();
+	animation_set_implementation(pourAnimation, &pourImplementation);
+	animation_set_duration(pourAnimation, POUR_SPEED);
+	animation_set_handlers(pourAnimation, (AnimationHandlers) {
+		.started = (AnimationStartedHandler) NULL,
+		.stopped = (AnimationStoppedHandler) pour_animation_stopped,
+	}, NULL);
+	animation_schedule(pourAnimation);
+}
+
+/**********************************************/
+/***** HELPER METHODS - TRANSITION GOVERNOR ***/
+/**********************************************/
+
+/* milliseconds on a clock that only matters for differences */
+static uint32_t now_ms() {
+	time_t seconds;
+	uint16_t millis;
+	time_ms(&seconds, &millis);
+	return (uint32_t)seconds * 1000 + millis;
+}
+
+/* full animation when there's battery to spare and buttons aren't being hammered, fewer frames as either
+   gets tighter, and a straight cut when the battery is low or the user is skipping through */
+static int choose_transition_style() {
+	uint32_t now = now_ms();
+	uint32_t sinceLast = now - lastTransitionTime;
+	lastTransitionTime = now;
+#if TRANSITION_GOVERNOR
+	BatteryChargeState battery = battery_state_service_peek();
+	if (sinceLast < GOVERNOR_RAPID_INPUT || (!battery.is_charging && battery.charge_percent <= GOVERNOR_LOW_BATTERY)) {
+		return TRANSITION_CUT;
+	}
+	if (sinceLast < GOVERNOR_STEADY_INPUT || (!battery.is_charging && battery.charge_percent <= GOVERNOR_MID_BATTERY)) {
+		return TRANSITION_REDUCED;
+	}
+#endif
+	return TRANSITION_FULL;
+}
+
+/* the reduced transition moves the layers in REDUCED_FRAMES jumps - the layers only move (and so only
+   repaint) when the animation reaches the next jump */
+static void stepped_animation_update(Animation *animation, const AnimationProgress progress) {
+	int frame = progress * REDUCED_FRAMES / ANIMATION_NORMALIZED_MAX;
+	if (frame == steppedFrame) {
+		return;
+	}
+	steppedFrame = frame;
+	for (int i = 0; i < 3; i++) {
+		GRect from = steppedFrom[i];
+		GRect to = steppedTo[i];
+		layer_set_frame(steppedLayers[i], GRect(from.origin.x + (to.origin.x - from.origin.x) * frame / REDUCED_FRAMES,
+				from.origin.y + (to.origin.y - from.origin.y) * frame / REDUCED_FRAMES, to.size.w, to.size.h));
+	}
+}
+
+static const AnimationImplementation steppedImplementation = {
+	.update = stepped_animation_update,
+};
+
+static void start_stepped_animation(Layer *moving[3], GRect to[3]) {
+	for (int i = 0; i < 3; i++) {
+		steppedLayers[i] = moving[i];
+		steppedFrom[i] = layer_get_frame(moving[i]);
+		steppedTo[i] = to[i];
+	}
+	steppedFrame = 0;
+	steppedAnimation = animation_create();
+	animation_set_implementation(steppedAnimation, &steppedImplementation);
+	animation_set_duration(steppedAnimation, ANIMATION_SPEED);
+	animation_set_handlers(steppedAnimation, (AnimationHandlers) {
+		.started = (AnimationStartedHandler) NULL,
+		.stopped = (AnimationStoppedHandler) layer_animation_ended,
+	}, NULL);
+	transitionAnimation = steppedAnimation;
+	animation_schedule(steppedAnimation);
+}
+
+/* a button pressed mid-transition - stop its animations where they are, put its layers where they were going
+   and end it, so the next one starts from a settled window. The animations' own stops come in as stale */
+static void finish_transition() {
+	if (!transitionAnimation) {
+		return;
+	}
+	transitionAnimation = NULL;
+	Animation *running[] = { (Animation *)animations[BACKGROUND], (Animation *)animations[LAYER],
+			(Animation *)animations[HEADER], steppedAnimation };
+	for (unsigned int i = 0; i < ARRAY_LENGTH(running); i++) {
+		if (running[i] && animation_is_scheduled(running[i])) {
+			animation_unschedule(running[i]);
+		}
+	}
+	for (int i = 0; i < 3; i++) {
+		layer_set_frame(transitionLayers[i], transitionTo[i]);
+	}
+	layer_animation_ended(NULL, true, NULL);
+}
+
+/* what a transition cost - logged after its settled repaint, so every style has its frames counted */
+static void log_transition_stats() {
+	transitionLogPending = false;
+	
+	/* report how much drawing culling saved over the transition */
+	int drawn, culled;
+	get_graphics_draw_stats(&drawn, &culled, true);
+#if DRAW_TIMING
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "transition: %d components drawn, %d culled, %d layer paints skipped", drawn, culled, skippedPaints);
+	int recorded, replays, commandsRecorded, commandsReplayed, replayMillis;
+	get_display_list_stats(&recorded, &replays, &commandsRecorded, &commandsReplayed, &replayMillis);
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "display lists: %d recorded (%d commands), %d replays (%d commands, %d ms)",
+			recorded, commandsRecorded, replays, commandsReplayed, replayMillis);
+	static const char *styles[] = { "full", "reduced", "cut" };
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "%s transition: %d frames", styles[transitionStyle], transitionFrames);
+	for (int i = 0; i < 2; i++) {
+		APP_LOG(APP_LOG_LEVEL_DEBUG, "%s quality: %d paints in %d ms", i ? "preview" : "full", tierPaints[i], tierMillis[i]);
+		tierPaints[i] = 0;
+		tierMillis[i] = 0;
+	}
+	
+	/* blitted against drawn - build with DRAW_DITHERED 0 to draw on black & white screens too */
+	int blits, blitsMillis, draws, drawsMillis;
+	get_dithered_stats(&blits, &blitsMillis, &draws, &drawsMillis);
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "built in drinks at full size: %d blitted in %d ms, %d drawn in %d ms", blits,
+			blitsMillis, draws, drawsMillis);
+#endif
+	skippedPaints = 0;
+	transitionFrames = 0;
+}
+
+/**********************************************/
+/******* HELPER METHODS - IDLE PREFETCH *******/
+/**********************************************/
+
+/* timer fired with nothing else going on - prefetch as part of the next paint of the active layer */
+static void prefetch_timer_callback(void *data) {
+	prefetchTimer = NULL;
+	prefetchPending = true;
+	layer_mark_dirty(graphicDrawLayer[active]);
+}
+
+/* (re)start the prefetch timer once things have settled */
+static void schedule_prefetch() {
+	if (prefetchTimer) {
+		app_timer_cancel(prefetchTimer);
+	}
+	prefetchTimer = app_timer_register(PREFETCH_DELAY, prefetch_timer_callback, NULL);
+}
+
+/* called on any input - drop any prefetch that hasn't happened yet */
+static void cancel_prefetch() {
+	if (prefetchTimer) {
+		app_timer_cancel(prefetchTimer);
+		prefetchTimer = NULL;
+	}
+	prefetchPending = false;
+}
+
 /**********************************************/
 /***** HELPER METHODS - TEMP LAYER DRAWING ****/
 /**********************************************/
 
+/* the part of a draw layer that can be seen, in its own coordinates - clipped to the screen, and during a
+   transition the active layer is also clipped to whatever the background mask doesn't cover */
+static GRect visible_part(Layer *l, int layer) {
+	GRect frame = layer_get_frame(l);
+	int top = frame.origin.y;
+	int bottom = frame.origin.y + frame.size.h;
+	top = (top < 0) ? 0 : top;
+	bottom = (bottom > SCREEN_HEIGHT) ? SCREEN_HEIGHT : bottom;
+	
+	if (maskShowing && layer == active) {
+		/* the mask is the full width of the draw layers, so it only ever trims the top or bottom */
+		GRect mask = layer_get_frame(graphicBackgroundLayer);
+		if (mask.origin.y <= top) {
+			top = (mask.origin.y + mask.size.h > top) ? mask.origin.y + mask.size.h : top;
+		} else {
+			bottom = (mask.origin.y < bottom) ? mask.origin.y : bottom;
+		}
+	}
+	
+	return GRect(0, top - frame.origin.y, frame.size.w, (bottom > top) ? bottom - top : 0);
+}
+
+/* draw layers are children of the window's root layer, so their frame origin is their position on screen;
+   layers that can't be seen at all aren't painted, and a pending prefetch is done in the active layer's
+   paint, before the layer paints over it */
+static void paint_draw_layer(Layer *l, GContext *ctx, int layer) {
+	GPoint origin = layer_get_frame(l).origin;
+	GRect visible = visible_part(l, layer);
+	if (visible.size.h == 0) {
+		skippedPaints++;
+		return;
+	}
+	
+	if (prefetchPending && layer == active) {
+		prefetchPending = false;
+		GRect bounds = layer_get_bounds(l);
+		prefetch_graphics_image(next_up(drawingItem[active]), ctx, origin, bounds, BG_COLOUR);
+		prefetch_graphics_image(next_down(drawingItem[active]), ctx, origin, bounds, BG_COLOUR);
+		
+#if DRAW_TIMING
+		int hits, misses;
+		get_graphics_cache_stats(&hits, &misses);
+		APP_LOG(APP_LOG_LEVEL_DEBUG, "render cache: %d hits, %d misses", hits, misses);
+#endif
+	}
+	
+#if DRAW_TIMING
+	/* time each paint, for comparing the quality tiers */
+	time_t paintSeconds, seconds;
+	uint16_t paintMillis, millis;
+	time_ms(&paintSeconds, &paintMillis);
+#endif
+	draw_graphics_image(drawingItem[layer], ctx, origin, visible);
+#if DRAW_TIMING
+	time_ms(&seconds, &millis);
+	tierPaints[previewing]++;
+	tierMillis[previewing] += (seconds - paintSeconds) * 1000 + millis - paintMillis;
+#endif
+}
+
 static void update_layer_1_proc(Layer *l, GContext *ctx) {
-	draw_graphics_image(drawingItem[0], ctx);
+	paint_draw_layer(l, ctx, 0);
 }
 
 static void update_layer_2_proc(Layer *l, GContext *ctx) {
-	draw_graphics_image(drawingItem[1],ctx);
+	paint_draw_layer(l, ctx, 1);
+}
+
+/* the cup layer is the last of the drawing to paint, so the first time it does is the first full frame */
+static void update_cup_layer_proc(Layer *l, GContext *ctx) {
+	draw_cup_frame(ctx, layer_get_frame(l).origin);
+	transitionFrames += (maskShowing || transitionLogPending) ? 1 : 0;
+	if (transitionLogPending) {
+		log_transition_stats();
+	}
+	
+	if (firstFramePending) {
+		firstFramePending = false;
+#if DRAW_TIMING
+		time_t seconds;
+		uint16_t millis;
+		time_ms(&seconds, &millis);
+		APP_LOG(APP_LOG_LEVEL_DEBUG, "first frame after %d ms (%s start)",
+				(int)((seconds - startSeconds) * 1000 + millis - startMillis),
+				graphics_cache_restored() ? "warm" : "cold");
+#endif
+		
+		/* the first frame is up - make the rest of the window once the app is idle */
+		stagingTimer = app_timer_register(0, staging_timer_callback, NULL);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include <pebble.h>
+#include "name_index.h"
+
+/********************************************/
+/*************** DECLARATIONS ***************/
+/********************************************/
+
+/* see tools/pack_index.py for the layout - a count, the bucket starts, then drink numbers in name order */
+#define HEADER_SIZE 2
+
+/* read a little endian uint16 from a buffer */
+static int read_uint16(const uint8_t *bytes) {
+	return bytes[0] | (bytes[1] << 8);
+}
+
+/********************************************/
+/****************** LOOKUP ******************/
+/********************************************/
+
+/* fold a letter to upper case, leaving anything else alone */
+static char fold_case(char c) {
+	return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+int name_index_compare(const char *a, const char *b) {
+	while (*a && fold_case(*a) == fold_case(*b)) {
+		a++;
+		b++;
+	}
+	return (unsigned char)fold_case(*a) - (unsigned char)fold_case(*b);
+}
+
+int name_index_bucket(char first) {
+	if (first >= 'a' && first <= 'z') {
+		return first - 'a';
+	}
+	if (first >= 'A' && first <= 'Z') {
+		return first - 'A';
+	}
+	return NAME_INDEX_OTHER;
+}
+
+/* a bucket's start & end are next to each other in the table, and the start is where its first drink is in the
+   sorted list */
+int name_index_first(uint32_t resourceId, int bucket) {
+	if (bucket < 0 || bucket >= NAME_INDEX_BUCKETS) {
+		return -1;
+	}
+	
+	ResHandle handle = resource_get_handle(resourceId);
+	uint8_t range[4];
+	resource_load_byte_range(handle, HEADER_SIZE + 2 * bucket, range, 4);
+	int start = read_uint16(range);
+	if (start == read_uint16(&range[2])) {
+		return -1;
+	}
+	
+	uint8_t item[2];
+	size_t sorted = HEADER_SIZE + 2 * (NAME_INDEX_BUCKETS + 1);
+	resource_load_byte_range(handle, sorted + 2 * start, item, 2);
+	return read_uint16(item);
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <pebble.h>
+
+/* the buckets in a name index - a letter from 'A' to 'Z', or this for names that don't start with a letter */
+#define NAME_INDEX_OTHER 26
+#define NAME_INDEX_BUCKETS 27
+
+/* compare two names the way the index is sorted - ignoring case */
+int name_index_compare(const char *a, const char *b);
+
+/* which bucket a name (or a letter) falls into */
+int name_index_bucket(char first);
+
+/* the first drink, in name order, whose name falls into bucket - -1 if there are none. Made by
+   tools/pack_index.py; two small reads of the resource whatever the size of the catalog */
+int name_index_first(uint32_t resourceId, int bucket);
@@ -0,0 +1,75 @@
+#include <pebble.h>
+#include "path_arena.h"
+
+/********************************************/
+/*************** DECLARATIONS ***************/
+/********************************************/
+
+/* each chunk is a header followed by its space */
+struct PathArenaChunk {
+	PathArenaChunk *next;
+	size_t size;
+	size_t used;
+};
+
+#define ALIGNMENT sizeof(void *)
+
+/********************************************/
+/**************** ALLOCATION ****************/
+/********************************************/
+
+PathArena* path_arena_create(size_t chunk_size) {
+	PathArena *arena = malloc(sizeof(PathArena));
+	if (arena) {
+		memset(arena, 0, sizeof(PathArena));
+		arena->chunk_size = chunk_size;
+	}
+	return arena;
+}
+
+/* allocate from the newest chunk, or start a new one if it's full - the tail of the full chunk is wasted,
+   but paths are built a few at a time so there's never much of it */
+void* path_arena_alloc(PathArena *arena, size_t size) {
+	size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	
+	PathArenaChunk *chunk = arena->chunks;
+	if (!chunk || chunk->size - chunk->used < size) {
+		size_t chunkSize = (size > arena->chunk_size) ? size : arena->chunk_size;
+		chunk = malloc(sizeof(PathArenaChunk) + chunkSize);
+		if (!chunk) {
+			return NULL;
+		}
+		chunk->next = arena->chunks;
+		chunk->size = chunkSize;
+		chunk->used = 0;
+		arena->chunks = chunk;
+		arena->num_chunks++;
+		arena->bytes_reserved += chunkSize;
+	}
+	
+	void *memory = (uint8_t *)(chunk + 1) + chunk->used;
+	chunk->used += size;
+	arena->bytes_used += size;
+	arena->num_allocations++;
+	return memory;
+}
+
+GPath* path_arena_alloc_path(PathArena *arena, uint32_t num_points) {
+	GPath *path = path_arena_alloc(arena, sizeof(GPath) + num_points * sizeof(GPoint));
+	if (path) {
+		memset(path, 0, sizeof(GPath));
+		path->num_points = num_points;
+		path->points = (GPoint *)(path + 1);
+	}
+	return path;
+}
+
+void path_arena_destroy(PathArena *arena) {
+	PathArenaChunk *chunk = arena->chunks;
+	while (chunk) {
+		PathArenaChunk *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	free(arena);
+}
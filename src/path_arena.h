@@ -0,0 +1,27 @@
+#pragma once
+#include <pebble.h>
+
+/* a chain of heap chunks that paths are carved out of one after another - nothing is freed on its own, the
+   whole arena goes at once, so paths that live and die together don't fragment the heap */
+typedef struct PathArenaChunk PathArenaChunk;
+
+typedef struct {
+	size_t chunk_size;
+	PathArenaChunk *chunks;
+	int num_chunks;
+	size_t bytes_reserved;
+	size_t bytes_used;
+	int num_allocations;
+} PathArena;
+
+/* make an empty arena - nothing is reserved until the first allocation */
+PathArena* path_arena_create(size_t chunk_size);
+
+/* size bytes from the arena, word aligned (NULL if out of memory) */
+void* path_arena_alloc(PathArena *arena, size_t size);
+
+/* a GPath with room for num_points straight after it, laid out as gpath_builder_create_path does */
+GPath* path_arena_alloc_path(PathArena *arena, uint32_t num_points);
+
+/* free every chunk, and with them everything allocated from the arena */
+void path_arena_destroy(PathArena *arena);
@@ -0,0 +1,349 @@
+#include <pebble.h>
+#include "span_cache.h"
+
+/********************************************/
+/*************** DECLARATIONS ***************/
+/********************************************/
+
+#define MAX_RUN_LENGTH 255
+
+/* the capture in progress - a copy of the pixels under the box before drawing */
+static uint8_t *savedPixels = NULL;
+static GRect savedBox;
+static GPoint savedOrigin;
+
+/* pixels are stored straight after the runs */
+static uint8_t* span_set_pixels(SpanSet *set) {
+	return (uint8_t *)&set->runs[set->num_runs];
+}
+
+/********************************************/
+/***************** CAPTURE ******************/
+/********************************************/
+
+#ifdef PBL_COLOR
+/* check every row of box (screen coordinates) is within the frame buffer */
+static bool box_on_screen(GBitmap *fb, GRect box) {
+	GRect bounds = gbitmap_get_bounds(fb);
+	if (box.origin.y < 0 || box.origin.y + box.size.h > bounds.size.h) {
+		return false;
+	}
+	for (int y = box.origin.y; y < box.origin.y + box.size.h; y++) {
+		GBitmapDataRowInfo row = gbitmap_get_data_row_info(fb, y);
+		if (box.origin.x < row.min_x || box.origin.x + box.size.w - 1 > row.max_x) {
+			return false;
+		}
+	}
+	return true;
+}
+#endif
+
+/* copy the saved box between the frame buffer and a buffer - into the frame buffer if toScreen */
+static void copy_box(GBitmap *fb, uint8_t *buffer, bool toScreen) {
+	for (int y = 0; y < savedBox.size.h; y++) {
+		GBitmapDataRowInfo row = gbitmap_get_data_row_info(fb, savedOrigin.y + savedBox.origin.y + y);
+		uint8_t *screen = &row.data[savedOrigin.x + savedBox.origin.x];
+		uint8_t *copy = &buffer[y * savedBox.size.w];
+		if (toScreen) {
+			memcpy(screen, copy, savedBox.size.w);
+		} else {
+			memcpy(copy, screen, savedBox.size.w);
+		}
+	}
+}
+
+/* take a copy of the pixels under box, ready to compare once drawing is done */
+bool span_capture_begin(GContext *ctx, GRect box, GPoint origin) {
+#ifdef PBL_COLOR
+	if (savedPixels || box.size.w <= 0 || box.size.h <= 0 || box.origin.x < 0 || box.origin.y < 0
+			|| box.origin.x + box.size.w > 256 || box.origin.y + box.size.h > 256) {
+		return false;
+	}
+
+	GBitmap *fb = graphics_capture_frame_buffer(ctx);
+	if (!fb) {
+		return false;
+	}
+
+	GRect screenBox = GRect(box.origin.x + origin.x, box.origin.y + origin.y, box.size.w, box.size.h);
+	if (box_on_screen(fb, screenBox)) {
+		savedPixels = malloc(box.size.w * box.size.h);
+	}
+
+	if (savedPixels) {
+		savedBox = box;
+		savedOrigin = origin;
+		copy_box(fb, savedPixels, false);
+	}
+
+	graphics_release_frame_buffer(ctx, fb);
+	return savedPixels != NULL;
+#else
+	/* runs are stored a byte per pixel, which only matches the 8-bit colour frame buffer */
+	return false;
+#endif
+}
+
+/* walk the box comparing against the saved copy - counts runs & pixels, and fills set if given. With covered,
+   the pixels marked in it are taken instead of the ones that changed */
+static void scan_changes(GBitmap *fb, const uint8_t *covered, SpanSet *set, int *numRuns, int *numPixels) {
+	uint8_t *pixels = set ? span_set_pixels(set) : NULL;
+	*numRuns = 0;
+	*numPixels = 0;
+
+	for (int y = 0; y < savedBox.size.h; y++) {
+		GBitmapDataRowInfo row = gbitmap_get_data_row_info(fb, savedOrigin.y + savedBox.origin.y + y);
+		uint8_t *now = &row.data[savedOrigin.x + savedBox.origin.x];
+		uint8_t *before = &savedPixels[y * savedBox.size.w];
+		const uint8_t *mask = covered ? &covered[y * savedBox.size.w] : NULL;
+		int x = 0;
+		while (x < savedBox.size.w) {
+			if (mask ? !mask[x] : now[x] == before[x]) {
+				x++;
+				continue;
+			}
+			/* start of a run of changed pixels */
+			int start = x;
+			while (x < savedBox.size.w && (mask ? mask[x] : now[x] != before[x]) && x - start < MAX_RUN_LENGTH) {
+				x++;
+			}
+			if (set) {
+				set->runs[*numRuns] = (SpanRun) {
+					.y = savedBox.origin.y + y,
+					.x = savedBox.origin.x + start,
+					.length = x - start,
+				};
+				memcpy(&pixels[*numPixels], &now[start], x - start);
+			}
+			*numRuns += 1;
+			*numPixels += x - start;
+		}
+	}
+}
+
+/* record the pixels in the box - the covered ones if given, otherwise the ones changed since the capture began */
+static SpanSet* capture_runs(GContext *ctx, const uint8_t *covered) {
+	SpanSet *set = NULL;
+	GBitmap *fb = graphics_capture_frame_buffer(ctx);
+	if (fb) {
+		/* count first so the set is allocated at exactly the right size */
+		int numRuns, numPixels;
+		scan_changes(fb, covered, NULL, &numRuns, &numPixels);
+		set = malloc(sizeof(SpanSet) + numRuns * sizeof(SpanRun) + numPixels);
+		if (set) {
+			set->num_runs = numRuns;
+			set->num_pixels = numPixels;
+			scan_changes(fb, covered, set, &numRuns, &numPixels);
+		}
+		graphics_release_frame_buffer(ctx, fb);
+	}
+	return set;
+}
+
+/* compare the frame buffer with the saved copy and record every pixel that changed */
+SpanSet* span_capture_end(GContext *ctx) {
+	if (!savedPixels) {
+		return NULL;
+	}
+
+	SpanSet *set = capture_runs(ctx, NULL);
+	free(savedPixels);
+	savedPixels = NULL;
+	return set;
+}
+
+#define TOUCHED 1
+#define UNFILLED 2
+
+/* flag each pixel in the box the fill doesn't reach (it's clipped) or the stroke draws on */
+static void mark_pixels(GContext *ctx, uint8_t *covered, GColor colour, uint8_t flag) {
+	GBitmap *fb = graphics_capture_frame_buffer(ctx);
+	if (!fb) {
+		return;
+	}
+	for (int y = 0; y < savedBox.size.h; y++) {
+		GBitmapDataRowInfo row = gbitmap_get_data_row_info(fb, savedOrigin.y + savedBox.origin.y + y);
+		uint8_t *now = &row.data[savedOrigin.x + savedBox.origin.x];
+		for (int x = 0; x < savedBox.size.w; x++) {
+			if (now[x] != colour.argb) {
+				covered[y * savedBox.size.w + x] |= flag;
+			}
+		}
+	}
+	graphics_release_frame_buffer(ctx, fb);
+}
+
+/* fill the box with colour and stroke over it, marking what the stroke touches */
+static void mark_stroke(GContext *ctx, uint8_t *covered, GColor colour, void (*stroke)(GContext *ctx, GPath *path),
+		GPath *path) {
+	graphics_context_set_fill_color(ctx, colour);
+	graphics_fill_rect(ctx, savedBox, 0, GCornerNone);
+	mark_pixels(ctx, covered, colour, UNFILLED);
+	stroke(ctx, path);
+	mark_pixels(ctx, covered, colour, TOUCHED);
+}
+
+/* stroke path into box and record every pixel the stroke touches, even where it's the same colour as what was
+   under it - whatever it draws differs from black or from white, so it's drawn over each to find them, then
+   drawn for real over what was there */
+SpanSet* capture_stroke(GContext *ctx, GRect box, GPoint origin, void (*stroke)(GContext *ctx, GPath *path),
+		GPath *path) {
+	if (!span_capture_begin(ctx, box, origin)) {
+		stroke(ctx, path);
+		return NULL;
+	}
+
+	SpanSet *set = NULL;
+	uint8_t *covered = calloc(box.size.w * box.size.h, 1);
+	if (covered) {
+		mark_stroke(ctx, covered, GColorBlack, stroke, path);
+		mark_stroke(ctx, covered, GColorWhite, stroke, path);
+		for (int i = 0; i < box.size.w * box.size.h; i++) {
+			covered[i] = (covered[i] == TOUCHED);
+		}
+		GBitmap *fb = graphics_capture_frame_buffer(ctx);
+		if (fb) {
+			copy_box(fb, savedPixels, true);
+			graphics_release_frame_buffer(ctx, fb);
+		}
+	}
+	stroke(ctx, path);
+	if (covered) {
+		set = capture_runs(ctx, covered);
+	}
+
+	free(covered);
+	free(savedPixels);
+	savedPixels = NULL;
+	return set;
+}
+
+/* work out the colour & alpha of a pixel from how it was drawn over black and over white - the further
+   apart they are, the more of the background shows through */
+static uint8_t overlay_pixel(GColor8 overBlack, GColor8 overWhite) {
+	int alpha = (9 - (overWhite.r - overBlack.r) - (overWhite.g - overBlack.g) - (overWhite.b - overBlack.b) + 1) / 3;
+	if (alpha <= 0) {
+		return GColorClear.argb;
+	}
+	int r = overBlack.r * 3 / alpha;
+	int g = overBlack.g * 3 / alpha;
+	int b = overBlack.b * 3 / alpha;
+	return (alpha << 6) | ((r > 3 ? 3 : r) << 4) | ((g > 3 ? 3 : g) << 2) | (b > 3 ? 3 : b);
+}
+
+/* draw into box over black and then over white, and turn the difference into a bitmap with alpha that
+   can be overlaid on any background - the frame buffer is put back as it was afterwards */
+GBitmap* capture_overlay(GContext *ctx, GRect box, GPoint origin, void (*draw)(GContext *ctx)) {
+	if (!span_capture_begin(ctx, box, origin)) {
+		return NULL;
+	}
+	
+	GBitmap *overlay = gbitmap_create_blank(box.size, GBitmapFormat8Bit);
+	uint8_t *overBlack = malloc(box.size.w * box.size.h);
+	
+	if (overlay && overBlack) {
+		/* draw over black and keep a copy */
+		graphics_context_set_fill_color(ctx, GColorBlack);
+		graphics_fill_rect(ctx, box, 0, GCornerNone);
+		draw(ctx);
+		GBitmap *fb = graphics_capture_frame_buffer(ctx);
+		copy_box(fb, overBlack, false);
+		graphics_release_frame_buffer(ctx, fb);
+		
+		/* draw over white and compare */
+		graphics_context_set_fill_color(ctx, GColorWhite);
+		graphics_fill_rect(ctx, box, 0, GCornerNone);
+		draw(ctx);
+		fb = graphics_capture_frame_buffer(ctx);
+		for (int y = 0; y < box.size.h; y++) {
+			GBitmapDataRowInfo row = gbitmap_get_data_row_info(fb, origin.y + box.origin.y + y);
+			GBitmapDataRowInfo out = gbitmap_get_data_row_info(overlay, y);
+			for (int x = 0; x < box.size.w; x++) {
+				out.data[x] = overlay_pixel((GColor8) { .argb = overBlack[y * box.size.w + x] },
+						(GColor8) { .argb = row.data[origin.x + box.origin.x + x] });
+			}
+		}
+		graphics_release_frame_buffer(ctx, fb);
+	} else if (overlay) {
+		gbitmap_destroy(overlay);
+		overlay = NULL;
+	}
+	
+	/* put the frame buffer back */
+	GBitmap *fb = graphics_capture_frame_buffer(ctx);
+	if (fb) {
+		copy_box(fb, savedPixels, true);
+		graphics_release_frame_buffer(ctx, fb);
+	}
+	free(overBlack);
+	free(savedPixels);
+	savedPixels = NULL;
+	return overlay;
+}
+
+/* copy box straight out of the frame buffer into a bitmap of its own */
+GBitmap* capture_bitmap(GContext *ctx, GRect box, GPoint origin) {
+	if (!span_capture_begin(ctx, box, origin)) {
+		return NULL;
+	}
+	
+	/* the saved copy is exactly the pixels we want */
+	GBitmap *bitmap = gbitmap_create_blank(box.size, GBitmapFormat8Bit);
+	if (bitmap) {
+		for (int y = 0; y < box.size.h; y++) {
+			GBitmapDataRowInfo row = gbitmap_get_data_row_info(bitmap, y);
+			memcpy(row.data, &savedPixels[y * box.size.w], box.size.w);
+		}
+	}
+	
+	free(savedPixels);
+	savedPixels = NULL;
+	return bitmap;
+}
+
+/********************************************/
+/****************** REPLAY ******************/
+/********************************************/
+
+/* copy the recorded runs into the frame buffer, clipping anything that's off screen or outside clip */
+void span_set_replay(SpanSet *set, GContext *ctx, GPoint origin, GRect clip) {
+	GBitmap *fb = graphics_capture_frame_buffer(ctx);
+	if (!fb) {
+		return;
+	}
+
+	int height = gbitmap_get_bounds(fb).size.h;
+	uint8_t *pixels = span_set_pixels(set);
+	for (int i = 0; i < set->num_runs; i++) {
+		SpanRun run = set->runs[i];
+		int y = origin.y + run.y;
+		int x = origin.x + run.x;
+		int skip = 0;
+		int length = run.length;
+		if (y >= 0 && y < height && run.y >= clip.origin.y && run.y < clip.origin.y + clip.size.h) {
+			GBitmapDataRowInfo row = gbitmap_get_data_row_info(fb, y);
+			int minX = (origin.x + clip.origin.x > row.min_x) ? origin.x + clip.origin.x : row.min_x;
+			int maxX = (origin.x + clip.origin.x + clip.size.w - 1 < row.max_x) ? origin.x + clip.origin.x + clip.size.w - 1 : row.max_x;
+			if (x < minX) {
+				skip = minX - x;
+			}
+			if (x + length - 1 > maxX) {
+				length = maxX - x + 1;
+			}
+			if (length > skip) {
+				memcpy(&row.data[x + skip], &pixels[skip], length - skip);
+			}
+		}
+		pixels += run.length;
+	}
+
+	graphics_release_frame_buffer(ctx, fb);
+}
+
+size_t span_set_size(SpanSet *set) {
+	return sizeof(SpanSet) + set->num_runs * sizeof(SpanRun) + set->num_pixels;
+}
+
+void span_set_destroy(SpanSet *set) {
+	free(set);
+}
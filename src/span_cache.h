@@ -0,0 +1,43 @@
+#pragma once
+#include <pebble.h>
+
+/* one horizontal run of recorded pixels, in layer coordinates */
+typedef struct {
+	uint8_t y;
+	uint8_t x;
+	uint8_t length;
+} SpanRun;
+
+/* a set of pixel runs recorded from the frame buffer - the runs are followed in memory by their pixels */
+typedef struct {
+	uint16_t num_runs;
+	uint16_t num_pixels;
+	SpanRun runs[];
+} SpanSet;
+
+/* start recording the pixels changed inside box (layer coordinates) - false if box isn't fully on screen */
+bool span_capture_begin(GContext *ctx, GRect box, GPoint origin);
+
+/* finish recording, returning the pixels changed since span_capture_begin (NULL if out of memory) */
+SpanSet* span_capture_end(GContext *ctx);
+
+/* stroke path, recording every pixel it touches in box (layer coordinates) - unlike span_capture_end, pixels the
+   stroke leaves the same colour are kept too. The stroke is drawn either way; NULL if box isn't fully on screen */
+SpanSet* capture_stroke(GContext *ctx, GRect box, GPoint origin, void (*stroke)(GContext *ctx, GPath *path),
+		GPath *path);
+
+/* draw into box over black and over white, returning the result as a bitmap with alpha so it can be
+   overlaid on anything - the frame buffer is left as it was (NULL if box isn't fully on screen) */
+GBitmap* capture_overlay(GContext *ctx, GRect box, GPoint origin, void (*draw)(GContext *ctx));
+
+/* copy box (layer coordinates) out of the frame buffer into a new bitmap - NULL if box isn't fully on screen */
+GBitmap* capture_bitmap(GContext *ctx, GRect box, GPoint origin);
+
+/* write the recorded pixels back into the frame buffer for a layer at origin - only inside clip (layer coordinates),
+   as the layer's own clipping doesn't apply to the frame buffer */
+void span_set_replay(SpanSet *set, GContext *ctx, GPoint origin, GRect clip);
+
+/* number of heap bytes held by a span set */
+size_t span_set_size(SpanSet *set);
+
+void span_set_destroy(SpanSet *set);
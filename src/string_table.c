@@ -0,0 +1,69 @@
+#include <pebble.h>
+#include "string_table.h"
+
+/********************************************/
+/*************** DECLARATIONS ***************/
+/********************************************/
+
+/* see tools/pack_strings.py for the layout - a 4 byte header, then the word & string offset tables */
+#define HEADER_SIZE 4
+#define FIRST_WORD 0x80
+#define CHUNK_SIZE 16
+
+/* read a little endian uint16 out of the resource */
+static int read_offset(ResHandle handle, size_t position) {
+	uint8_t bytes[2];
+	resource_load_byte_range(handle, position, bytes, 2);
+	return bytes[0] | (bytes[1] << 8);
+}
+
+/********************************************/
+/****************** DECODE ******************/
+/********************************************/
+
+/* the packed string is read a chunk at a time and each dictionary word read as it's reached, so nothing but
+   the output is ever held in memory */
+char* string_table_decode(uint32_t resourceId, int index) {
+	ResHandle handle = resource_get_handle(resourceId);
+	uint8_t header[HEADER_SIZE];
+	resource_load_byte_range(handle, 0, header, HEADER_SIZE);
+	int numStrings = header[0];
+	int numWords = header[1];
+	int longest = header[2] | (header[3] << 8);
+	if (index < 0 || index >= numStrings) {
+		return NULL;
+	}
+	
+	size_t wordOffsets = HEADER_SIZE;
+	size_t stringOffsets = wordOffsets + 2 * (numWords + 1);
+	size_t wordData = stringOffsets + 2 * (numStrings + 1);
+	size_t stringData = wordData + read_offset(handle, wordOffsets + 2 * numWords);
+	int start = read_offset(handle, stringOffsets + 2 * index);
+	int end = read_offset(handle, stringOffsets + 2 * (index + 1));
+	
+	char *text = malloc(longest + 1);
+	if (!text) {
+		return NULL;
+	}
+	
+	int length = 0;
+	uint8_t chunk[CHUNK_SIZE];
+	for (int position = start; position < end; position += CHUNK_SIZE) {
+		int size = (end - position < CHUNK_SIZE) ? end - position : CHUNK_SIZE;
+		resource_load_byte_range(handle, stringData + position, chunk, size);
+		for (int i = 0; i < size; i++) {
+			if (chunk[i] < FIRST_WORD) {
+				text[length++] = chunk[i];
+				continue;
+			}
+			/* a word from the dictionary */
+			int word = chunk[i] - FIRST_WORD;
+			int wordStart = read_offset(handle, wordOffsets + 2 * word);
+			int wordLength = read_offset(handle, wordOffsets + 2 * (word + 1)) - wordStart;
+			resource_load_byte_range(handle, wordData + wordStart, (uint8_t *)&text[length], wordLength);
+			length += wordLength;
+		}
+	}
+	text[length] = '\0';
+	return text;
+}
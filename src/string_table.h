@@ -0,0 +1,6 @@
+#pragma once
+#include <pebble.h>
+
+/* decode one string from a packed string table resource (made by tools/pack_strings.py) into a new heap buffer
+   the caller frees - NULL if index is out of range or there isn't the memory */
+char* string_table_decode(uint32_t resourceId, int index);
@@ -0,0 +1,314 @@
+#!/usr/bin/env python
+#
+# Renders every drink in src/catalog.h at the design size and dithers it to 1-bit, for the black & white
+# platforms to blit instead of drawing - read on the watch by draw_dithered in src/draw_layers.c. The layers are
+# painted the way src/draw_layers.c paints them (fill then outline for liquids, rows of circles for foam), with
+# each colour's brightness turned into an ordered dither, so milk, water & coffee still look different. The cup
+# isn't included, as it's drawn over the top by its own layer.
+#
+# Everything drawn is read from src/draw_layers.c rather than copied here - the design size, interiorRecipe, the
+# levels & colours, and the paint functions' bodies, followed down to their draw_liquid & draw_foam_row calls -
+# so an edit there changes the dithered drinks too. Anything it can't follow is an error, as is a colour that
+# isn't one of the SDK's.
+#
+# Each drink is cropped to the pixels that aren't black, which is the background on those platforms.
+#
+# Layout (little endian):
+#   uint8  number of drinks
+#   uint8  design width, design height
+#   per drink: uint8 x, y, width, height of the crop, uint16 offset of its rows (from the start of the row data)
+#   row data - each row (width + 7) / 8 bytes, leftmost pixel in the lowest bit, 1 for white
+#
+# Usage: dither_drinks.py src/catalog.h src/draw_layers.c resources/data/dithered_drinks.bin
+
+import math
+import re
+import struct
+import sys
+
+from pack_strings import read_catalog
+
+SUPERSAMPLE = 4
+
+# 4x4 ordered dither thresholds, in sixteenths
+BAYER = [[0, 8, 2, 10], [12, 4, 14, 6], [3, 11, 1, 9], [15, 7, 13, 5]]
+
+# the SDK's named colours - each channel is two bits, so 0x00, 0x55, 0xAA or 0xFF
+PEBBLE_COLOURS = {
+    'Black': 0x000000, 'OxfordBlue': 0x000055, 'DukeBlue': 0x0000AA, 'Blue': 0x0000FF,
+    'DarkGreen': 0x005500, 'MidnightGreen': 0x005555, 'CobaltBlue': 0x0055AA, 'BlueMoon': 0x0055FF,
+    'IslamicGreen': 0x00AA00, 'JaegerGreen': 0x00AA55, 'TiffanyBlue': 0x00AAAA, 'VividCerulean': 0x00AAFF,
+    'Green': 0x00FF00, 'Malachite': 0x00FF55, 'MediumSpringGreen': 0x00FFAA, 'Cyan': 0x00FFFF,
+    'BulgarianRose': 0x550000, 'ImperialPurple': 0x550055, 'Indigo': 0x5500AA, 'ElectricUltramarine': 0x5500FF,
+    'ArmyGreen': 0x555500, 'DarkGray': 0x555555, 'Liberty': 0x5555AA, 'VeryLightBlue': 0x5555FF,
+    'KellyGreen': 0x55AA00, 'MayGreen': 0x55AA55, 'CadetBlue': 0x55AAAA, 'PictonBlue': 0x55AAFF,
+    'BrightGreen': 0x55FF00, 'ScreaminGreen': 0x55FF55, 'MediumAquamarine': 0x55FFAA, 'ElectricBlue': 0x55FFFF,
+    'DarkCandyAppleRed': 0xAA0000, 'JazzberryJam': 0xAA0055, 'Purple': 0xAA00AA, 'VividViolet': 0xAA00FF,
+    'WindsorTan': 0xAA5500, 'RoseVale': 0xAA5555, 'Purpureus': 0xAA55AA, 'LavenderIndigo': 0xAA55FF,
+    'Limerick': 0xAAAA00, 'Brass': 0xAAAA55, 'LightGray': 0xAAAAAA, 'BabyBlueEyes': 0xAAAAFF,
+    'SpringBud': 0xAAFF00, 'Inchworm': 0xAAFF55, 'MintGreen': 0xAAFFAA, 'Celeste': 0xAAFFFF,
+    'Red': 0xFF0000, 'Folly': 0xFF0055, 'FashionMagenta': 0xFF00AA, 'Magenta': 0xFF00FF,
+    'Orange': 0xFF5500, 'SunsetOrange': 0xFF5555, 'BrilliantRose': 0xFF55AA, 'ShockingPink': 0xFF55FF,
+    'ChromeYellow': 0xFFAA00, 'Rajah': 0xFFAA55, 'Melon': 0xFFAAAA, 'RichBrilliantLavender': 0xFFAAFF,
+    'Yellow': 0xFFFF00, 'Icterine': 0xFFFF55, 'PastelYellow': 0xFFFFAA, 'White': 0xFFFFFF,
+}
+
+
+def luminance(rgb):
+    return (0.299 * ((rgb >> 16) & 0xFF) + 0.587 * ((rgb >> 8) & 0xFF) + 0.114 * (rgb & 0xFF)) / 255.0
+
+
+class DrawLayers(object):
+    # what the drinks are painted from, read out of src/draw_layers.c - its #defines (levels, colours, sizes),
+    # interiorRecipe, and the bodies of its functions, so the paint calls can be followed down to the liquids &
+    # foam rows they end in. Comments are dropped first, so commented out drawing isn't read
+
+    def __init__(self, draw_layers_path):
+        with open(draw_layers_path) as f:
+            source = f.read()
+        source = re.sub(r'/\*.*?\*/', ' ', source, flags=re.S)
+        source = re.sub(r'//[^\n]*', '', source)
+        self.path = draw_layers_path
+        self.defines = dict(re.findall(r'^#define[ \t]+(\w+)[ \t]+([^\n]+?)[ \t]*$', source, re.M))
+        self.functions = {}
+        for function in re.finditer(r'^void (\w+)\(([^)]*)\)\s*\{(.*?)^\}', source, re.M | re.S):
+            params = [param.split()[-1].lstrip('*') for param in function.group(2).split(',') if param.strip()]
+            self.functions[function.group(1)] = (params, function.group(3))
+
+        recipe = re.search(r'interiorRecipe\[\]\s*=\s*\{(.*?)\};', source, re.S)
+        if not recipe:
+            raise ValueError('no interiorRecipe in %s' % draw_layers_path)
+        self.interior = [(int(x), int(y)) for x, y in re.findall(r'\{\s*(-?\d+)\s*,\s*(-?\d+)\s*\}', recipe.group(1))]
+        self.design_width = self.evaluate('DESIGN_WIDTH', {})
+        self.design_height = self.evaluate('DESIGN_HEIGHT', {})
+
+        # liquids are outlined by stroke_outline, in its colour & width
+        outline = self.calls('stroke_outline', [])
+        self.outline_colour = self.evaluate(self.find_call(outline, 'set_stroke_colour')[0], {})
+        width = re.search(r'stroke_width\((\w+)\)', self.functions['stroke_outline'][1])
+        self.outline_stroke = self.evaluate(width.group(1), {})
+
+    def evaluate(self, expression, bindings):
+        # a number, a colour (as 0xRRGGBB), or a name or #define standing for one - COLOR_FALLBACK takes the colour,
+        # so the brightness is what the colour screens show
+        expression = expression.strip()
+        if expression in bindings:
+            return bindings[expression]
+        if re.match(r'^-?\d+$', expression):
+            return int(expression)
+        fallback = re.match(r'^COLOR_FALLBACK\(\s*(\w+)\s*,\s*\w+\s*\)$', expression)
+        if fallback:
+            return self.evaluate(fallback.group(1), bindings)
+        if expression.startswith('GColor'):
+            if expression[6:] not in PEBBLE_COLOURS:
+                raise ValueError('unknown colour %s in %s' % (expression, self.path))
+            return PEBBLE_COLOURS[expression[6:]]
+        if expression in self.defines:
+            return self.evaluate(self.defines[expression], bindings)
+        raise ValueError("can't work out %s in %s" % (expression, self.path))
+
+    def calls(self, function, args):
+        # the calls a function makes with ctx, as (name, arguments) with its parameters bound to args
+        if function not in self.functions:
+            raise ValueError('no function %s in %s' % (function, self.path))
+        params, body = self.functions[function]
+        bindings = dict(zip(params[1:], args))
+        return [(call.group(1), [self.bind(arg, bindings) for arg in call.group(2).split(',') if arg.strip()])
+                for call in re.finditer(r'(\w+)\(ctx((?:\s*,[^;]*?)?)\);', body)]
+
+    @staticmethod
+    def bind(arg, bindings):
+        arg = arg.strip()
+        return bindings.get(arg, arg)
+
+    @staticmethod
+    def find_call(calls, name):
+        for call, args in calls:
+            if call == name:
+                return args
+        raise ValueError('no call to %s' % name)
+
+    def drawing(self, paint):
+        # follow a drink's paint calls down to what they draw - ('liquid', level, colour) and ('foam', y, from, to,
+        # step, radius, colour), with the stroke colour carried along as set_stroke_colour sets it
+        drawn = []
+        self.follow([(call, []) for call in paint], drawn, {'stroke': None})
+        return drawn
+
+    def follow(self, calls, drawn, state):
+        for call, args in calls:
+            if call == 'set_stroke_colour':
+                state['stroke'] = self.evaluate(args[0], {})
+            elif call == 'draw_liquid':
+                drawn.append(('liquid', self.evaluate(args[0], {}), self.evaluate(args[1], {})))
+            elif call == 'draw_foam_row':
+                drawn.append(('foam',) + tuple(self.evaluate(arg, {}) for arg in args) + (state['stroke'],))
+            elif call in self.functions:
+                if len(self.functions[call][0]) != len(args) + 1:
+                    raise ValueError('%s called with %d arguments in %s' % (call, len(args), self.path))
+                self.follow(self.calls(call, args), drawn, state)
+            else:
+                raise ValueError("don't know how to dither %s in %s" % (call, self.path))
+
+
+def read_paints(catalog_path):
+    # the draw_ calls in each DRINK(id, "header", "detail", paint) entry, in order
+    with open(catalog_path) as f:
+        source = f.read().replace('\\\n', ' ')
+    paints = []
+    for entry in re.finditer(r'DRINK\(\s*\w+\s*,\s*"(?:[^"\\]|\\.)*"\s*,\s*"(?:[^"\\]|\\.)*"\s*,(.*?)\)(?=[ \t]*DRINK\(|[ \t]*\n)',
+                             source, re.S):
+        paints.append(re.findall(r'(draw_\w+)\(ctx\)', entry.group(1)))
+    return paints
+
+
+def flatten_interior(recipe):
+    # fine enough that the polygon is smooth at this size - a point is a pixel centre. The recipe is top left, top
+    # right, then two curves as (to, control 1, control 2)
+    points = [recipe[0], recipe[1]]
+    start = recipe[1]
+    for to, c1, c2 in (recipe[2:5], recipe[5:8]):
+        for i in range(1, 33):
+            t = i / 32.0
+            u = 1 - t
+            points.append(tuple(u * u * u * start[k] + 3 * u * u * t * c1[k] + 3 * u * t * t * c2[k] + t * t * t * to[k]
+                                for k in range(2)))
+        start = to
+    return points[:-1]
+
+
+def liquid_polygon(interior, level):
+    # the interior with everything above the level cut away, as liquid_path does
+    out = []
+    for i, a in enumerate(interior):
+        b = interior[(i + 1) % len(interior)]
+        if a[1] >= level:
+            out.append(a)
+        if (a[1] >= level) != (b[1] >= level):
+            out.append((a[0] + (b[0] - a[0]) * (level - a[1]) / float(b[1] - a[1]), level))
+    return out
+
+
+class Canvas(object):
+    def __init__(self, width, height):
+        self.width = width * SUPERSAMPLE
+        self.height = height * SUPERSAMPLE
+        self.samples = [[0.0] * self.width for _ in range(self.height)]
+
+    @staticmethod
+    def to_sample(value):
+        # pixel centre coordinates to supersample coordinates
+        return (value + 0.5) * SUPERSAMPLE
+
+    def fill_polygon(self, points, shade):
+        points = [(self.to_sample(x), self.to_sample(y)) for x, y in points]
+        for sy in range(self.height):
+            y = sy + 0.5
+            crossings = []
+            for i, a in enumerate(points):
+                b = points[(i + 1) % len(points)]
+                if (a[1] <= y) != (b[1] <= y):
+                    crossings.append(a[0] + (b[0] - a[0]) * (y - a[1]) / (b[1] - a[1]))
+            crossings.sort()
+            for left, right in zip(crossings[0::2], crossings[1::2]):
+                for sx in range(max(0, int(math.ceil(left - 0.5))), min(self.width, int(math.floor(right - 0.5)) + 1)):
+                    self.samples[sy][sx] = shade
+
+    def stroke_polygon(self, points, width, shade):
+        half = width * SUPERSAMPLE / 2.0
+        points = [(self.to_sample(x), self.to_sample(y)) for x, y in points]
+        for i, a in enumerate(points):
+            b = points[(i + 1) % len(points)]
+            dx, dy = b[0] - a[0], b[1] - a[1]
+            length = dx * dx + dy * dy
+            for sy in range(max(0, int(min(a[1], b[1]) - half)), min(self.height, int(max(a[1], b[1]) + half) + 1)):
+                for sx in range(max(0, int(min(a[0], b[0]) - half)), min(self.width, int(max(a[0], b[0]) + half) + 1)):
+                    px, py = sx + 0.5, sy + 0.5
+                    t = 0 if length == 0 else max(0.0, min(1.0, ((px - a[0]) * dx + (py - a[1]) * dy) / length))
+                    if math.hypot(px - a[0] - t * dx, py - a[1] - t * dy) <= half:
+                        self.samples[sy][sx] = shade
+
+    def stroke_circle(self, centre, radius, shade):
+        cx, cy = self.to_sample(centre[0]), self.to_sample(centre[1])
+        r = radius * SUPERSAMPLE
+        half = SUPERSAMPLE / 2.0
+        for sy in range(max(0, int(cy - r - half)), min(self.height, int(cy + r + half) + 1)):
+            for sx in range(max(0, int(cx - r - half)), min(self.width, int(cx + r + half) + 1)):
+                if abs(math.hypot(sx + 0.5 - cx, sy + 0.5 - cy) - r) <= half:
+                    self.samples[sy][sx] = shade
+
+    def dither(self):
+        # average each pixel's samples, then compare against its place in the ordered dither
+        area = float(SUPERSAMPLE * SUPERSAMPLE)
+        pixels = []
+        for y in range(self.height // SUPERSAMPLE):
+            row = []
+            for x in range(self.width // SUPERSAMPLE):
+                total = sum(self.samples[y * SUPERSAMPLE + j][x * SUPERSAMPLE + i]
+                            for j in range(SUPERSAMPLE) for i in range(SUPERSAMPLE))
+                row.append(total / area * 16 > BAYER[y % 4][x % 4] + 0.5)
+            pixels.append(row)
+        return pixels
+
+
+def render(paint, draw_layers, interior):
+    canvas = Canvas(draw_layers.design_width, draw_layers.design_height)
+    outline = luminance(draw_layers.outline_colour)
+    for layer in draw_layers.drawing(paint):
+        if layer[0] == 'liquid':
+            polygon = liquid_polygon(interior, layer[1])
+            if len(polygon) >= 3:
+                canvas.fill_polygon(polygon, luminance(layer[2]))
+                canvas.stroke_polygon(polygon, draw_layers.outline_stroke, outline)
+        else:
+            y, start, end, step, radius, colour = layer[1:]
+            for x in range(start, end + 1, step):
+                canvas.stroke_circle((x, y), radius, luminance(colour))
+    return canvas.dither()
+
+
+def pack_rows(pixels):
+    # crop to the white pixels, then pack each row a bit per pixel
+    rows = [y for y, row in enumerate(pixels) if any(row)]
+    columns = [x for x in range(len(pixels[0])) if any(row[x] for row in pixels)]
+    if not rows:
+        return (0, 0, 0, 0), bytearray()
+    left, top = columns[0], rows[0]
+    width, height = columns[-1] - left + 1, rows[-1] - top + 1
+    data = bytearray()
+    for row in pixels[top:top + height]:
+        packed = bytearray((width + 7) // 8)
+        for x in range(width):
+            if row[left + x]:
+                packed[x // 8] |= 1 << (x % 8)
+        data.extend(packed)
+    return (left, top, width, height), data
+
+
+def pack(catalog_path, draw_layers_path, output_path):
+    draw_layers = DrawLayers(draw_layers_path)
+    interior = flatten_interior(draw_layers.interior)
+    names = [header.decode('ascii') for header, detail in read_catalog(catalog_path)]
+    entries = bytearray()
+    row_data = bytearray()
+    sizes = []
+    for name, paint in zip(names, read_paints(catalog_path)):
+        box, data = pack_rows(render(paint, draw_layers, interior))
+        entries.extend(struct.pack('<BBBBH', box[0], box[1], box[2], box[3], len(row_data)))
+        row_data.extend(data)
+        # loaded, a 1-bit bitmap's rows are padded to whole words
+        sizes.append((name, box[2], box[3], len(data), (box[2] + 31) // 32 * 4 * box[3]))
+
+    packed = bytearray(struct.pack('<BBB', len(entries) // 6, draw_layers.design_width, draw_layers.design_height))
+    packed.extend(entries)
+    packed.extend(row_data)
+    with open(output_path, 'wb') as f:
+        f.write(packed)
+
+    print('dithered drinks: %d drinks, %d bytes' % (len(entries) // 6, len(packed)))
+    for name, width, height, stored, loaded in sizes:
+        print('  %-12s %3dx%-3d %5d bytes stored, %5d on the heap once loaded' % (name, width, height, stored, loaded))
+
+
+if __name__ == '__main__':
+    pack(sys.argv[1], sys.argv[2], sys.argv[3])
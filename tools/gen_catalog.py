@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+#
+# Writes a synthetic catalog in the form of src/catalog.h, far bigger than the real one, for benchmarking the name
+# index against (tools/host/index_bench.c). Names are made up from short word lists, so plenty share a prefix,
+# differ only in case or repeat outright, and some start with digits, punctuation or the characters between 'Z' and
+# 'a' - the cases where sorting is easiest to get wrong. The same seed always gives the same catalog.
+#
+# Usage: gen_catalog.py count output.h [seed]
+
+import random
+import sys
+
+STYLES = ['Iced', 'Flat', 'Long', 'Dirty', 'Double', 'Spiced', 'Salted', 'Honey', 'Oat', 'Vanilla', 'Zesty',
+          'Yuzu', 'Quick', 'Xtra', 'Kyoto', 'Nitro', 'Ubuntu', 'Wild', 'Golden', 'Jasmine']
+DRINKS = ['Latte', 'Mocha', 'Cortado', 'Americano', 'Macchiato', 'Ristretto', 'Lungo', 'Affogato', 'Breve',
+          'Espresso', 'Frappe', 'Red Eye']
+# names that don't start with a letter, or that sort differently depending on which case they're folded to
+ODD_FIRSTS = ['1st', '3 Shot', '#', '(Hot)', '_Test', '[New]', '`Old`', '"Quoted"', "Joe's", 'Back\\slash']
+ODD_SECONDS = ['_', '[', '^', '`', 'a', 'B', 'y', 'Z']
+
+
+def literal(text):
+    return '"%s"' % text.replace('\\', '\\\\').replace('"', '\\"')
+
+
+def make_name(rng):
+    kind = rng.random()
+    if kind < 0.1:
+        name = '%s %s' % (rng.choice(ODD_FIRSTS), rng.choice(DRINKS))
+    elif kind < 0.2:
+        name = '%s%s %s' % (rng.choice(STYLES)[0], rng.choice(ODD_SECONDS), rng.choice(DRINKS))
+    else:
+        name = '%s %s' % (rng.choice(STYLES), rng.choice(DRINKS))
+    if rng.random() < 0.2:
+        name = rng.choice([name.lower(), name.upper()])
+    return name
+
+
+def generate(count, output_path, seed=1):
+    rng = random.Random(seed)
+    lines = ['#pragma once', '',
+             '/* %d synthetic drinks from tools/gen_catalog.py, seed %d - see src/catalog.h */' % (count, seed),
+             '#define DRINK_CATALOG(DRINK) \\']
+    for n in range(count):
+        lines.append('\tDRINK(SYNTHETIC_%d, %s, "Drink %d", draw_espresso_shot(ctx);) \\' %
+                     (n, literal(make_name(rng)), n))
+    lines.append('')
+    with open(output_path, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+    print('synthetic catalog: %d drinks' % count)
+
+
+if __name__ == '__main__':
+    generate(int(sys.argv[1]), sys.argv[2], int(sys.argv[3]) if len(sys.argv) > 3 else 1)
@@ -0,0 +1,81 @@
+/* size & time of the built in drinks on a black & white screen - each is painted into a draw layer the size of the
+   one on a 144x168 screen, first and then again once its caches are warm, noting the heap it holds on to after.
+   Built with DRAW_DITHERED 1 it blits the drinks tools/dither_drinks.py dithered; with 0 it draws them from their
+   paths, as the colour platforms do, so the two runs compare the blits against the vector path.
+
+   Desktop times are only a guide to the watch's - they show how the two compare, not what either costs there.
+
+   Usage: make -C tools/host dither */
+#include <time.h>
+#include <pebble.h>
+#include "shim_heap.h"
+#include "shim_app.h"
+#include "draw_layers.h"
+
+#ifndef HEAP_SIZE
+#define HEAP_SIZE 65536
+#endif
+#ifndef RESOURCE_DIR
+#define RESOURCE_DIR "../../resources/data"
+#endif
+
+/* the draw layer on a 144x168 screen, which is the design size - the only size the dithered drinks are blitted at */
+#define DRAW_LAYER GRect(5, 30, 123, 133)
+#define REPEATS 50
+
+static int drink;
+static double paintMicros;
+
+static double now_micros() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static void update_draw_layer(Layer *layer, GContext *ctx) {
+	double started = now_micros();
+	draw_graphics_image(drink, ctx, layer_get_frame(layer).origin, layer_get_bounds(layer));
+	paintMicros = now_micros() - started;
+}
+
+/* paint the layer once, for the time it took */
+static double paint(Layer *layer) {
+	layer_mark_dirty(layer);
+	shim_run(1);
+	return paintMicros;
+}
+
+int main(void) {
+	shim_heap_init(HEAP_SIZE);
+	shim_app_init(RESOURCE_DIR);
+	Window *window = window_create();
+	window_stack_push(window, false);
+	Layer *layer = layer_create(DRAW_LAYER);
+	layer_set_update_proc(layer, update_draw_layer);
+	layer_add_child(window_get_root_layer(window), layer);
+	set_graphics_size(DRAW_LAYER.size);
+
+	printf("%s\n", DRAW_DITHERED ? "blitted, dithered at build time:" : "drawn from paths:");
+	printf("%-12s %10s %10s %8s\n", "drink", "first us", "after us", "heap");
+	size_t before = shim_heap_stats().used;
+	double firstTotal = 0;
+	double warmTotal = 0;
+	for (drink = 0; drink < entry_count(); drink++) {
+		size_t used = shim_heap_stats().used;
+		double first = paint(layer);
+		double warm = 0;
+		for (int i = 0; i < REPEATS; i++) {
+			double micros = paint(layer);
+			warm = (i == 0 || micros < warm) ? micros : warm;
+		}
+		firstTotal += first;
+		warmTotal += warm;
+		printf("%-12s %10.1f %10.2f %8d\n", header_text(drink), first, warm, (int)(shim_heap_stats().used - used));
+	}
+	printf("%-12s %10.1f %10.2f %8d\n\n", "all", firstTotal, warmTotal, (int)(shim_heap_stats().used - before));
+
+	destroy_graphics_cache();
+	layer_destroy(layer);
+	window_destroy(window);
+	return shim_heap_stats().failed_allocations ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+/* golden test for the span cache - every drink is painted at each draw layer size twice, the first time stroked
+   for real (recording its strokes as it goes) and the second with the strokes copied back from the span cache and
+   the rest replayed from its display list. The two paints must match pixel for pixel; any that don't are listed
+   with the first pixel that differs, and the run fails.
+
+   The sizes are the draw layers on rectangular & round screens, and the design scaled down, so the strokes are
+   recorded at widths & transforms other than 1:1.
+
+   Usage: make -C tools/host golden */
+#include <pebble.h>
+#include "shim_heap.h"
+#include "shim_app.h"
+#include "draw_layers.h"
+
+#ifndef HEAP_SIZE
+#define HEAP_SIZE 65536
+#endif
+#ifndef RESOURCE_DIR
+#define RESOURCE_DIR "../../resources/data"
+#endif
+
+/* what's under the draw layers in the app */
+#define BACKGROUND GColorDarkGray
+#define MAX_LAYER_PIXELS (144 * 168)
+
+/* the draw layer on a 144x168 screen (which is the design size) and on a 180x180 one, then scaled down */
+static const GRect layers[] = {
+	{ { 5, 30 }, { 123, 133 } },
+	{ { 2, 2 }, { 135, 118 } },
+	{ { 10, 20 }, { 92, 100 } },
+	{ { 40, 40 }, { 61, 66 } },
+};
+
+static int drink;
+static uint8_t *paintedInto;
+
+/* paint the drink over the background, then copy out what it left in the layer */
+static void update_draw_layer(Layer *layer, GContext *ctx) {
+	GRect frame = layer_get_frame(layer);
+	graphics_context_set_fill_color(ctx, BACKGROUND);
+	graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
+	draw_graphics_image(drink, ctx, frame.origin, layer_get_bounds(layer));
+
+	GBitmap *fb = graphics_capture_frame_buffer(ctx);
+	for (int y = 0; y < frame.size.h; y++) {
+		GBitmapDataRowInfo row = gbitmap_get_data_row_info(fb, frame.origin.y + y);
+		memcpy(&paintedInto[y * frame.size.w], &row.data[frame.origin.x], frame.size.w);
+	}
+	graphics_release_frame_buffer(ctx, fb);
+}
+
+static void paint(Layer *layer, uint8_t *pixels) {
+	paintedInto = pixels;
+	layer_mark_dirty(layer);
+	shim_run(1);
+}
+
+int main(void) {
+	shim_heap_init(HEAP_SIZE);
+	shim_app_init(RESOURCE_DIR);
+	Window *window = window_create();
+	window_stack_push(window, false);
+
+	static uint8_t stroked[MAX_LAYER_PIXELS];
+	static uint8_t replayed[MAX_LAYER_PIXELS];
+	int differing = 0;
+	for (size_t l = 0; l < ARRAY_LENGTH(layers); l++) {
+		GSize size = layers[l].size;
+		Layer *layer = layer_create(layers[l]);
+		layer_set_update_proc(layer, update_draw_layer);
+		layer_add_child(window_get_root_layer(window), layer);
+		set_graphics_size(size);
+
+		int replays = 0;
+		for (drink = 0; drink < entry_count(); drink++) {
+			int hits, misses, hitsAfter, missesAfter;
+			paint(layer, stroked);
+			get_graphics_cache_stats(&hits, &misses);
+			paint(layer, replayed);
+			get_graphics_cache_stats(&hitsAfter, &missesAfter);
+			replays += hitsAfter - hits;
+
+			/* a drink with nothing to replay would pass without testing anything */
+			if (hitsAfter == hits || missesAfter != misses) {
+				printf("%dx%d: %s wasn't painted from the span cache (%d strokes replayed, %d stroked)\n", size.w,
+						size.h, header_text(drink), hitsAfter - hits, missesAfter - misses);
+				differing++;
+				continue;
+			}
+			for (int i = 0; i < size.w * size.h; i++) {
+				if (stroked[i] != replayed[i]) {
+					printf("%dx%d: %s differs from (%d, %d) - 0x%02x stroked, 0x%02x replayed\n", size.w, size.h,
+							header_text(drink), i % size.w, i / size.w, stroked[i], replayed[i]);
+					differing++;
+					break;
+				}
+			}
+		}
+		printf("%3dx%-3d %d drinks, %d strokes replayed\n", size.w, size.h, entry_count(), replays);
+
+		layer_destroy(layer);
+	}
+
+	destroy_graphics_cache();
+	window_destroy(window);
+	if (shim_heap_stats().failed_allocations) {
+		printf("FAILED: %d allocations failed\n", shim_heap_stats().failed_allocations);
+		return 1;
+	}
+	if (differing) {
+		printf("FAILED: %d paints from the caches don't match stroking\n", differing);
+		return 1;
+	}
+	printf("passed\n");
+	return 0;
+}
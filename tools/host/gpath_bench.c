@@ -0,0 +1,167 @@
+/* stress & timing harness for src/gpath_builder.c - flattens ordinary and degenerate curves (coincident points,
+   cusps, controls far past the ends, huge & tiny coordinates, jitter, then a run of random ones) at several
+   tolerances and scales, recording the time, subdivision depth and points each curve takes. Fails if any curve
+   goes over its budget.
+
+   Usage: make -C tools/host gpath */
+#include <time.h>
+#include <pebble.h>
+#include "gpath_builder.h"
+
+/* a curve is never subdivided deeper than MAX_RECURSION_DEPTH in src/gpath_builder.c, so it adds at most a
+   point per leaf plus its end point */
+#define DEPTH_BUDGET 8
+#define POINT_BUDGET ((1 << DEPTH_BUDGET) + 1)
+
+/* generous for a desktop - a curve anywhere near this has stopped being bounded */
+#define TIME_BUDGET_US 500
+
+#define REPEATS 200
+#define RANDOM_REPEATS 5
+#define RANDOM_CURVES 20000
+#define RANDOM_RANGE 2000
+#define BUILDER_POINTS 1024
+
+typedef struct {
+	const char *name;
+	GPoint start;
+	GPoint curve[3];
+} Case;
+
+/* curves are (to, control 1, control 2), as gpath_builder_curve_to_point takes them */
+static const Case cases[] = {
+	{ "cup side", {115, 20}, {{60, 100}, {115, 60}, {90, 100}} },
+	{ "handle", {114, 30}, {{122, 38}, {120, 25}, {123, 25}} },
+	{ "all points coincident", {50, 50}, {{50, 50}, {50, 50}, {50, 50}} },
+	{ "zero length, far controls", {50, 50}, {{50, 50}, {3000, -3000}, {-3000, 3000}} },
+	{ "cusp", {0, 0}, {{100, 0}, {150, 100}, {-50, 100}} },
+	{ "controls past the ends", {0, 0}, {{100, 0}, {300, 0}, {-200, 0}} },
+	{ "closed loop", {0, 0}, {{0, 0}, {200, 200}, {-200, 200}} },
+	{ "huge", {-16000, -16000}, {{16000, 16000}, {16000, -16000}, {-16000, 16000}} },
+	{ "full int16 range", {-32767, -32767}, {{32767, 32767}, {32767, -32767}, {-32767, 32767}} },
+	{ "one pixel", {10, 10}, {{11, 10}, {10, 11}, {11, 11}} },
+	{ "jitter", {0, 0}, {{100, 0}, {1, 1}, {99, -1}} },
+};
+
+static const int tolerances[] = { 10, 1 };
+static const int32_t scales[] = { GPATH_TRANSFORM_ONE, GPATH_TRANSFORM_ONE / 4, GPATH_TRANSFORM_ONE * 2 };
+
+typedef struct {
+	double micros;
+	int depth;
+	int points;
+	bool overflowed;
+} Result;
+
+static double now_micros() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+/* flatten one curve repeats times into a reused builder - the time is the fastest of them, so a run isn't failed
+   by the desktop scheduling something else part way through a curve */
+static Result flatten(GPathBuilder *builder, GPoint start, const GPoint *curve, int repeats) {
+	Result result = { 0 };
+	for (int i = 0; i < repeats; i++) {
+		builder->num_points = 0;
+		builder->max_depth = 0;
+		builder->overflowed = false;
+		double started = now_micros();
+		gpath_builder_move_to_point(builder, start);
+		gpath_builder_curve_to_point(builder, curve[0], curve[1], curve[2]);
+		double micros = now_micros() - started;
+		result.micros = (i == 0 || micros < result.micros) ? micros : result.micros;
+	}
+	result.depth = builder->max_depth;
+	result.points = builder->num_points - 1;
+	result.overflowed = builder->overflowed;
+	return result;
+}
+
+static bool within_budget(Result result) {
+	return !result.overflowed && result.depth <= DEPTH_BUDGET && result.points <= POINT_BUDGET
+			&& result.micros <= TIME_BUDGET_US;
+}
+
+/* a repeatable pseudo random coordinate */
+static uint32_t seed = 12345;
+static int16_t random_coordinate() {
+	seed = seed * 1103515245 + 12345;
+	return (int16_t)((seed >> 16) % (2 * RANDOM_RANGE + 1)) - RANDOM_RANGE;
+}
+
+int main(void) {
+	GPathBuilder *builder = gpath_builder_create(BUILDER_POINTS);
+	if (!builder) {
+		return 1;
+	}
+	int failures = 0;
+
+	printf("%-28s %9s %6s %8s %6s %10s\n", "curve", "tolerance", "scale", "us/curve", "depth", "points");
+	for (unsigned int c = 0; c < ARRAY_LENGTH(cases); c++) {
+		for (unsigned int t = 0; t < ARRAY_LENGTH(tolerances); t++) {
+			for (unsigned int s = 0; s < ARRAY_LENGTH(scales); s++) {
+				gpath_builder_set_tolerance(builder, tolerances[t]);
+				gpath_builder_set_transform(builder, (GPathTransform) { scales[s], scales[s], { 0, 0 } });
+				Result result = flatten(builder, cases[c].start, cases[c].curve, REPEATS);
+				bool ok = within_budget(result);
+				failures += ok ? 0 : 1;
+				printf("%-28s %9d %6.2f %8.2f %6d %10d%s\n", cases[c].name, tolerances[t],
+						(double)scales[s] / GPATH_TRANSFORM_ONE, result.micros, result.depth, result.points,
+						ok ? "" : "  OVER BUDGET");
+			}
+		}
+	}
+
+	/* random curves at the finest tolerance - the worst of each measure, from any curve */
+	gpath_builder_set_tolerance(builder, 1);
+	gpath_builder_set_transform(builder, GPathTransformIdentity);
+	Result worst = { 0 };
+	double total = 0;
+	static GPoint randomCurves[RANDOM_CURVES][4];
+	for (int i = 0; i < RANDOM_CURVES; i++) {
+		GPoint start = GPoint(random_coordinate(), random_coordinate());
+		GPoint *curve = &randomCurves[i][1];
+		randomCurves[i][0] = start;
+		for (int j = 0; j < 3; j++) {
+			curve[j] = GPoint(random_coordinate(), random_coordinate());
+		}
+		Result result = flatten(builder, start, curve, RANDOM_REPEATS);
+		total += result.micros;
+		if (!within_budget(result)) {
+			failures++;
+			printf("random curve %d over budget: (%d,%d) to (%d,%d) via (%d,%d) (%d,%d) - %.2f us, depth %d, %d points\n",
+					i, start.x, start.y, curve[0].x, curve[0].y, curve[1].x, curve[1].y, curve[2].x, curve[2].y,
+					result.micros, result.depth, result.points);
+		}
+		worst.micros = (result.micros > worst.micros) ? result.micros : worst.micros;
+		worst.depth = (result.depth > worst.depth) ? result.depth : worst.depth;
+		worst.points = (result.points > worst.points) ? result.points : worst.points;
+	}
+	printf("%d random curves: mean %.2f us, worst %.2f us, depth %d, %d points\n", RANDOM_CURVES,
+			total / RANDOM_CURVES, worst.micros, worst.depth, worst.points);
+
+	/* transforming the same curves' points on their own - the only part of flattening with fixed work per point,
+	   so all a packed 16 bit layout could speed up. The subdivision after it branches on each curve's angles */
+	double transformMicros = 0;
+	volatile int sink = 0;
+	for (int r = 0; r < RANDOM_REPEATS; r++) {
+		double started = now_micros();
+		for (int i = 0; i < RANDOM_CURVES; i++) {
+			for (int j = 0; j < 4; j++) {
+				GPoint point = gpath_transform_point(&builder->transform, randomCurves[i][j]);
+				sink += point.x + point.y;
+			}
+		}
+		double micros = (now_micros() - started) / RANDOM_CURVES;
+		transformMicros = (r == 0 || micros < transformMicros) ? micros : transformMicros;
+	}
+	printf("transforming their points alone: %.3f us a curve, %.1f%% of flattening them\n", transformMicros,
+			100 * transformMicros / (total / RANDOM_CURVES));
+
+	gpath_builder_destroy(builder);
+	printf("budgets: depth %d, %d points, %d us per curve - %s\n", DEPTH_BUDGET, POINT_BUDGET, TIME_BUDGET_US,
+			failures ? "FAILED" : "all within");
+	return failures ? 1 : 0;
+}
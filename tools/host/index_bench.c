@@ -0,0 +1,97 @@
+/* lookup benchmark for src/name_index.c - for every bucket, checks the drink name_index_first gives against a brute
+   force search of the catalog's names with name_index_compare, and times both. The catalog is compiled in (CATALOG,
+   src/catalog.h or one written by tools/gen_catalog.py) and its index read from RESOURCE_DIR, as packed from it by
+   tools/pack_index.py. Fails on any mismatch, or if a lookup reads more from the resource than READ_BUDGET reads of
+   BYTES_BUDGET bytes - the same two small reads whatever the size of the catalog.
+
+   Usage: make -C tools/host index [INDEX_SIZES="n ..."] */
+#include <time.h>
+#include <pebble.h>
+#include "shim_app.h"
+#include "name_index.h"
+#include CATALOG
+
+#define READ_BUDGET 2
+#define BYTES_BUDGET 6
+
+#define REPEATS 20
+#define LOOKUP_REPEATS 1000
+
+/* the catalog's names, in drink order */
+#define DRINK_NAME(id, header, detail, ...) header,
+static const char *names[] = { DRINK_CATALOG(DRINK_NAME) };
+
+static double now_micros() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+/* the first drink in bucket by name_index_compare, the earlier drink winning a tie as in the packed index - -1 if
+   there are none */
+static int brute_force_first(int bucket) {
+	int first = -1;
+	for (unsigned int i = 0; i < ARRAY_LENGTH(names); i++) {
+		if (name_index_bucket(names[i][0]) == bucket && (first < 0 || name_index_compare(names[i], names[first]) < 0)) {
+			first = (int)i;
+		}
+	}
+	return first;
+}
+
+/* the fastest of repeats passes over every bucket, per lookup */
+static double time_lookups(int (*lookup)(int bucket), int repeats) {
+	double fastest = 0;
+	volatile int sink = 0;
+	for (int r = 0; r < REPEATS; r++) {
+		double started = now_micros();
+		for (int i = 0; i < repeats; i++) {
+			for (int bucket = 0; bucket < NAME_INDEX_BUCKETS; bucket++) {
+				sink += lookup(bucket);
+			}
+		}
+		double micros = (now_micros() - started) / (repeats * NAME_INDEX_BUCKETS);
+		fastest = (r == 0 || micros < fastest) ? micros : fastest;
+	}
+	return fastest;
+}
+
+static int index_first(int bucket) {
+	return name_index_first(RESOURCE_ID_NAME_INDEX, bucket);
+}
+
+int main(void) {
+	shim_app_init(RESOURCE_DIR);
+	int failures = 0;
+
+	int mostReads = 0;
+	int mostBytes = 0;
+	for (int bucket = 0; bucket < NAME_INDEX_BUCKETS; bucket++) {
+		int reads = shim_resource_reads();
+		int bytes = shim_resource_bytes_read();
+		int found = index_first(bucket);
+		reads = shim_resource_reads() - reads;
+		bytes = shim_resource_bytes_read() - bytes;
+		mostReads = (reads > mostReads) ? reads : mostReads;
+		mostBytes = (bytes > mostBytes) ? bytes : mostBytes;
+
+		int expected = brute_force_first(bucket);
+		if (found != expected) {
+			failures++;
+			printf("bucket %c: index gives %d (%s), brute force %d (%s)\n",
+					(bucket == NAME_INDEX_OTHER) ? '#' : 'A' + bucket, found, (found >= 0) ? names[found] : "none",
+					expected, (expected >= 0) ? names[expected] : "none");
+		}
+	}
+	if (mostReads > READ_BUDGET || mostBytes > BYTES_BUDGET) {
+		failures++;
+	}
+
+	int bruteRepeats = (ARRAY_LENGTH(names) > LOOKUP_REPEATS) ? 1 : LOOKUP_REPEATS / ARRAY_LENGTH(names);
+	double indexMicros = time_lookups(index_first, LOOKUP_REPEATS);
+	double bruteMicros = time_lookups(brute_force_first, bruteRepeats);
+	printf("%6d drinks, %6d byte index: %d reads of %d bytes, %.3f us a lookup (brute force %.3f us) - %s\n",
+			(int)ARRAY_LENGTH(names), (int)resource_size(resource_get_handle(RESOURCE_ID_NAME_INDEX)), mostReads,
+			mostBytes, indexMicros, bruteMicros, failures ? "FAILED" : "all match");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+/* launch measurement for src/main.c - starts the app cold against the host shim, and notes how long it takes to
+   get its first frame up and the most heap it has used by then, then the same once the rest of the graphic window
+   has been made after it. Built with STAGED_LAUNCH 1 the layers only a transition needs wait until after the first
+   frame; with 0 they're all made as the window loads, so the two runs compare staged creation with making
+   everything up front.
+
+   Each launch is in a process of its own, as the app's statics can't be reset, and the time is the best of
+   REPEATS. Desktop times are only a guide to the watch's - they show how the two compare, not what either costs
+   there.
+
+   Usage: make -C tools/host launch [BW=1] */
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <pebble.h>
+#include "shim_heap.h"
+#include "shim_app.h"
+
+/* the app itself, with its main renamed so this file's can drive it */
+#define main coffee_guru_main
+#include "main.c"
+#undef main
+
+#ifndef HEAP_SIZE
+#define HEAP_SIZE 65536
+#endif
+#ifndef RESOURCE_DIR
+#define RESOURCE_DIR "../../resources/data"
+#endif
+
+#define REPEATS 20
+/* long enough for the window to finish pushing, the pour to run and the staging to be done */
+#define SETTLE_MS 1500
+
+typedef struct {
+	double firstFrameMicros;
+	uint32_t firstFrameMs;
+	size_t firstFramePeak;
+	size_t firstFrameUsed;
+	size_t settledPeak;
+	size_t settledUsed;
+	int failedAllocations;
+} Launch;
+
+static Launch launch;
+static double started;
+
+static double now_micros() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+/* stands in for the SDK's event loop - the app's been initialised when it's called, and is deinitialised after */
+void app_event_loop(void) {
+	while (firstFramePending) {
+		shim_run(1);
+	}
+	launch.firstFrameMicros = now_micros() - started;
+	launch.firstFrameMs = shim_now();
+	HeapStats stats = shim_heap_stats();
+	launch.firstFramePeak = stats.peak_used;
+	launch.firstFrameUsed = stats.used;
+
+	shim_run(SETTLE_MS);
+	stats = shim_heap_stats();
+	launch.settledPeak = stats.peak_used;
+	launch.settledUsed = stats.used;
+	launch.failedAllocations = stats.failed_allocations;
+}
+
+/* launch the app in a child process, which sends back what it measured - false if it didn't */
+static bool measure_launch(Launch *result) {
+	int fds[2];
+	if (pipe(fds) != 0) {
+		return false;
+	}
+	pid_t child = fork();
+	if (child == 0) {
+		close(fds[0]);
+		shim_heap_init(HEAP_SIZE);
+		shim_app_init(RESOURCE_DIR);
+		started = now_micros();
+		coffee_guru_main();
+		shim_app_exit();
+		_exit(write(fds[1], &launch, sizeof(launch)) == sizeof(launch) ? 0 : 1);
+	}
+	close(fds[1]);
+	bool received = child > 0 && read(fds[0], result, sizeof(*result)) == sizeof(*result);
+	close(fds[0]);
+	int status;
+	return received && waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(void) {
+	Launch best = { 0 };
+	for (int r = 0; r < REPEATS; r++) {
+		Launch run;
+		if (!measure_launch(&run)) {
+			printf("FAILED: the launch didn't finish\n");
+			return 1;
+		}
+		if (r == 0 || run.firstFrameMicros < best.firstFrameMicros) {
+			best = run;
+		}
+	}
+
+	printf("%s, %s: first frame after %.1f us (%d ms simulated), heap peak %d (%d in use); settled, heap peak %d "
+			"(%d in use)\n", STAGED_LAUNCH ? "staged" : "up front", PBL_IF_COLOR_ELSE("colour", "black & white"),
+			best.firstFrameMicros, (int)best.firstFrameMs, (int)best.firstFramePeak, (int)best.firstFrameUsed,
+			(int)best.settledPeak, (int)best.settledUsed);
+	if (best.failedAllocations) {
+		printf("FAILED: %d allocations failed\n", best.failedAllocations);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,455 @@
+/* host stand-in for the Pebble SDK's pebble.h - enough of it to build the watch sources in src/ with a desktop
+   compiler, for the stress tests & benchmarks in this directory. Types are laid out as the SDK has them, and
+   the calls are implemented in pebble_shim.c (geometry, maths & logging), shim_heap.c (the app heap) and
+   shim_app.c (everything else).
+
+   Builds as a rectangular colour platform, like basalt; define SHIM_BW for a black & white one, like aplite */
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifndef SHIM_BW
+#define PBL_COLOR 1
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#define COLOR_FALLBACK(color, bw) (color)
+#else
+#define PBL_BW 1
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_false)
+#define COLOR_FALLBACK(color, bw) (bw)
+#endif
+#define PBL_RECT 1
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+
+/********************************************/
+/***************** GEOMETRY *****************/
+/********************************************/
+
+typedef struct GPoint {
+	int16_t x;
+	int16_t y;
+} GPoint;
+#define GPoint(x, y) ((GPoint){(x), (y)})
+#define GPointZero GPoint(0, 0)
+
+typedef struct GSize {
+	int16_t w;
+	int16_t h;
+} GSize;
+#define GSize(w, h) ((GSize){(w), (h)})
+
+typedef struct GRect {
+	GPoint origin;
+	GSize size;
+} GRect;
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+#define GRectZero GRect(0, 0, 0, 0)
+
+bool gpoint_equal(const GPoint * const point_a, const GPoint * const point_b);
+bool grect_equal(const GRect * const rect_a, const GRect * const rect_b);
+
+typedef struct GPathInfo {
+	uint32_t num_points;
+	GPoint *points;
+} GPathInfo;
+
+typedef struct GPath {
+	uint32_t num_points;
+	GPoint *points;
+	int32_t rotation;
+	GPoint offset;
+} GPath;
+
+/********************************************/
+/******************* MATHS ******************/
+/********************************************/
+
+#define TRIG_MAX_ANGLE 0x10000
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+/* the angle of (x, y) from 0 to TRIG_MAX_ANGLE, as the SDK's lookup table gives it */
+int32_t atan2_lookup(int16_t y, int16_t x);
+
+/********************************************/
+/****************** LOGGING *****************/
+/********************************************/
+
+typedef enum {
+	APP_LOG_LEVEL_ERROR = 1,
+	APP_LOG_LEVEL_WARNING = 50,
+	APP_LOG_LEVEL_INFO = 100,
+	APP_LOG_LEVEL_DEBUG = 200,
+} AppLogLevel;
+
+/* logs go to stderr, and only when SHIM_LOG is set - a soak run would otherwise drown in them */
+void app_log(uint8_t level, const char *filename, int line, const char *fmt, ...);
+#define APP_LOG(level, fmt, ...) app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+/********************************************/
+/******************* HEAP *******************/
+/********************************************/
+
+size_t heap_bytes_free(void);
+size_t heap_bytes_used(void);
+
+/* with SHIM_HEAP, the sources' allocations come from a simulated app heap the size of the watch's, rather than
+   the desktop's - see shim_heap.h */
+#ifdef SHIM_HEAP
+void* shim_malloc(size_t size, const char *file, int line);
+void* shim_calloc(size_t count, size_t size, const char *file, int line);
+void* shim_realloc(void *ptr, size_t size, const char *file, int line);
+void shim_free(void *ptr);
+#define malloc(size) shim_malloc(size, __FILE__, __LINE__)
+#define calloc(count, size) shim_calloc(count, size, __FILE__, __LINE__)
+#define realloc(ptr, size) shim_realloc(ptr, size, __FILE__, __LINE__)
+#define free(ptr) shim_free(ptr)
+#endif
+
+/********************************************/
+/****************** COLOURS *****************/
+/********************************************/
+
+typedef union GColor8 {
+	uint8_t argb;
+	struct {
+		uint8_t b:2;
+		uint8_t g:2;
+		uint8_t r:2;
+		uint8_t a:2;
+	};
+} GColor8;
+typedef GColor8 GColor;
+
+#define GColorClear ((GColor8){.argb = 0x00})
+#define GColorBlack ((GColor8){.argb = 0xC0})
+#define GColorWhite ((GColor8){.argb = 0xFF})
+#define GColorDarkGray ((GColor8){.argb = 0xD5})
+#define GColorLightGray ((GColor8){.argb = 0xEA})
+#define GColorPastelYellow ((GColor8){.argb = 0xFE})
+#define GColorBabyBlueEyes ((GColor8){.argb = 0xEB})
+
+bool gcolor_equal(GColor8 color_a, GColor8 color_b);
+
+/********************************************/
+/***************** GRAPHICS *****************/
+/********************************************/
+
+typedef struct GContext GContext;
+typedef struct GBitmap GBitmap;
+typedef struct GFont_ *GFont;
+
+typedef enum {
+	GCornerNone = 0,
+	GCornerTopLeft = 1,
+	GCornerTopRight = 2,
+	GCornerBottomLeft = 4,
+	GCornerBottomRight = 8,
+	GCornersAll = 15,
+	GCornersTop = 3,
+	GCornersBottom = 12,
+	GCornersLeft = 5,
+	GCornersRight = 10,
+} GCornerMask;
+
+typedef enum {
+	GCompOpAssign,
+	GCompOpAssignInverted,
+	GCompOpOr,
+	GCompOpAnd,
+	GCompOpClear,
+	GCompOpSet,
+} GCompOp;
+
+typedef enum {
+	GBitmapFormat1Bit,
+	GBitmapFormat8Bit,
+	GBitmapFormat1BitPalette,
+	GBitmapFormat2BitPalette,
+	GBitmapFormat4BitPalette,
+	GBitmapFormat8BitCircular,
+} GBitmapFormat;
+
+typedef struct {
+	uint8_t *data;
+	int16_t min_x;
+	int16_t max_x;
+} GBitmapDataRowInfo;
+
+typedef enum {
+	GTextAlignmentLeft,
+	GTextAlignmentCenter,
+	GTextAlignmentRight,
+} GTextAlignment;
+
+typedef enum {
+	GTextOverflowModeWordWrap,
+	GTextOverflowModeTrailingEllipsis,
+	GTextOverflowModeFill,
+} GTextOverflowMode;
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width);
+void graphics_context_set_antialiased(GContext *ctx, bool enable);
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_rect(GContext *ctx, GRect rect);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+void graphics_draw_pixel(GContext *ctx, GPoint point);
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect);
+
+GPath* gpath_create(const GPathInfo *init);
+void gpath_destroy(GPath *path);
+void gpath_draw_filled(GContext *ctx, GPath *path);
+void gpath_draw_outline(GContext *ctx, GPath *path);
+void gpath_draw_outline_open(GContext *ctx, GPath *path);
+void gpath_move_to(GPath *path, GPoint point);
+
+GBitmap* graphics_capture_frame_buffer(GContext *ctx);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+
+GBitmap* gbitmap_create_blank(GSize size, GBitmapFormat format);
+void gbitmap_destroy(GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+uint8_t* gbitmap_get_data(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y);
+
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_18 "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_24_BOLD "RESOURCE_ID_GOTHIC_24_BOLD"
+#define FONT_KEY_GOTHIC_28_BOLD "RESOURCE_ID_GOTHIC_28_BOLD"
+#define FONT_KEY_BITHAM_42_BOLD "RESOURCE_ID_BITHAM_42_BOLD"
+
+GFont fonts_get_system_font(const char *font_key);
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+		const GTextOverflowMode overflow_mode, const GTextAlignment alignment, void *text_attributes);
+GSize graphics_text_layout_get_content_size(const char *text, GFont const font, const GRect box,
+		const GTextOverflowMode overflow_mode, const GTextAlignment alignment);
+
+/********************************************/
+/****************** LAYERS ******************/
+/********************************************/
+
+typedef struct Layer Layer;
+typedef struct TextLayer TextLayer;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer* layer_create(GRect frame);
+Layer* layer_create_with_data(GRect frame, size_t data_size);
+void* layer_get_data(const Layer *layer);
+void layer_destroy(Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_insert_below_sibling(Layer *layer_to_insert, Layer *below_sibling_layer);
+void layer_insert_above_sibling(Layer *layer_to_insert, Layer *above_sibling_layer);
+void layer_remove_from_parent(Layer *child);
+GRect layer_get_frame(const Layer *layer);
+GRect layer_get_bounds(const Layer *layer);
+void layer_set_frame(Layer *layer, GRect frame);
+void layer_set_bounds(Layer *layer, GRect bounds);
+void layer_set_hidden(Layer *layer, bool hidden);
+bool layer_get_hidden(const Layer *layer);
+void layer_set_clips(Layer *layer, bool clips);
+
+TextLayer* text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer* text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+const char* text_layer_get_text(TextLayer *text_layer);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment);
+GSize text_layer_get_content_size(TextLayer *text_layer);
+void text_layer_set_size(TextLayer *text_layer, const GSize max_size);
+
+/********************************************/
+/****************** WINDOWS *****************/
+/********************************************/
+
+typedef struct Window Window;
+typedef void *ClickRecognizerRef;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void *context);
+typedef void (*ClickConfigProvider)(void *context);
+typedef void (*WindowHandler)(Window *window);
+
+typedef struct WindowHandlers {
+	WindowHandler load;
+	WindowHandler appear;
+	WindowHandler disappear;
+	WindowHandler unload;
+} WindowHandlers;
+
+typedef enum {
+	BUTTON_ID_BACK,
+	BUTTON_ID_UP,
+	BUTTON_ID_SELECT,
+	BUTTON_ID_DOWN,
+	NUM_BUTTONS,
+} ButtonId;
+
+Window* window_create(void);
+void window_destroy(Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_background_color(Window *window, GColor background_color);
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider);
+void window_set_click_config_provider_with_context(Window *window, ClickConfigProvider click_config_provider,
+		void *context);
+Layer* window_get_root_layer(const Window *window);
+void window_stack_push(Window *window, bool animated);
+Window* window_stack_pop(bool animated);
+Window* window_stack_get_top_window(void);
+bool window_stack_contains_window(Window *window);
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler);
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms, ClickHandler handler);
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler,
+		ClickHandler up_handler);
+
+/********************************************/
+/**************** ANIMATIONS ****************/
+/********************************************/
+
+typedef struct Animation Animation;
+typedef struct PropertyAnimation PropertyAnimation;
+typedef uint32_t AnimationProgress;
+#define ANIMATION_NORMALIZED_MIN 0
+#define ANIMATION_NORMALIZED_MAX 65535
+
+typedef void (*AnimationStartedHandler)(Animation *animation, void *context);
+typedef void (*AnimationStoppedHandler)(Animation *animation, bool finished, void *context);
+typedef struct AnimationHandlers {
+	AnimationStartedHandler started;
+	AnimationStoppedHandler stopped;
+} AnimationHandlers;
+
+typedef void (*AnimationSetupImplementation)(Animation *animation);
+typedef void (*AnimationUpdateImplementation)(Animation *animation, const AnimationProgress progress);
+typedef void (*AnimationTeardownImplementation)(Animation *animation);
+typedef struct AnimationImplementation {
+	AnimationSetupImplementation setup;
+	AnimationUpdateImplementation update;
+	AnimationTeardownImplementation teardown;
+} AnimationImplementation;
+
+/* as in SDK 3, an animation is destroyed once it stops, whether it finished or was unscheduled */
+Animation* animation_create(void);
+bool animation_destroy(Animation *animation);
+bool animation_set_implementation(Animation *animation, const AnimationImplementation *implementation);
+bool animation_set_duration(Animation *animation, uint32_t duration_ms);
+bool animation_set_delay(Animation *animation, uint32_t delay_ms);
+bool animation_set_handlers(Animation *animation, AnimationHandlers callbacks, void *context);
+void* animation_get_context(Animation *animation);
+bool animation_schedule(Animation *animation);
+bool animation_unschedule(Animation *animation);
+bool animation_is_scheduled(Animation *animation);
+
+PropertyAnimation* property_animation_create_layer_frame(Layer *layer, GRect *from_frame, GRect *to_frame);
+void property_animation_destroy(PropertyAnimation *property_animation);
+Animation* property_animation_get_animation(PropertyAnimation *property_animation);
+
+/********************************************/
+/****************** TIMERS ******************/
+/********************************************/
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer_handle);
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+
+/********************************************/
+/************ STORAGE & RESOURCES ***********/
+/********************************************/
+
+typedef int32_t status_t;
+#define S_SUCCESS 0
+#define E_DOES_NOT_EXIST -4
+#define PERSIST_DATA_MAX_LENGTH 256
+
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+status_t persist_write_int(const uint32_t key, const int32_t value);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+int persist_write_data(const uint32_t key, const void *data, const size_t size);
+status_t persist_delete(const uint32_t key);
+
+/* as the SDK generates them from appinfo.json - the files are read from resources/data */
+#define RESOURCE_ID_COFFEE_BEAN 1
+#define RESOURCE_ID_DETAIL_TEXT 2
+#define RESOURCE_ID_NAME_INDEX 3
+#define RESOURCE_ID_DITHERED_DRINKS 4
+
+typedef void *ResHandle;
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle h);
+size_t resource_load(ResHandle h, uint8_t *buffer, size_t max_length);
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t *buffer, size_t num_bytes);
+
+/********************************************/
+/************** PHONE & SYSTEM **************/
+/********************************************/
+
+typedef enum {
+	APP_MSG_OK = 0,
+	APP_MSG_SEND_TIMEOUT = 2,
+	APP_MSG_NOT_CONNECTED = 8,
+	APP_MSG_BUSY = 64,
+} AppMessageResult;
+
+typedef enum {
+	TUPLE_BYTE_ARRAY = 0,
+	TUPLE_CSTRING = 1,
+	TUPLE_UINT = 2,
+	TUPLE_INT = 3,
+} TupleType;
+
+typedef struct __attribute__((__packed__)) Tuple {
+	uint32_t key;
+	TupleType type:8;
+	uint16_t length;
+	/* sized rather than zero length, as the SDK has them, so indexing past the first byte isn't warned about */
+	union {
+		uint8_t data[PERSIST_DATA_MAX_LENGTH];
+		char cstring[PERSIST_DATA_MAX_LENGTH];
+		uint32_t uint32;
+		int32_t int32;
+	} value[];
+} Tuple;
+
+typedef struct DictionaryIterator DictionaryIterator;
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void *context);
+
+Tuple* dict_find(const DictionaryIterator *iter, const uint32_t key);
+int dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value);
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+uint32_t app_message_inbox_size_maximum(void);
+
+typedef struct {
+	uint8_t charge_percent;
+	bool is_charging;
+	bool is_plugged;
+} BatteryChargeState;
+BatteryChargeState battery_state_service_peek(void);
+
+void light_enable_interaction(void);
+void app_event_loop(void);
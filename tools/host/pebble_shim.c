@@ -0,0 +1,46 @@
+/* host implementations of the SDK calls declared in pebble.h */
+#include <math.h>
+#include <stdarg.h>
+#include <pebble.h>
+
+/********************************************/
+/***************** GEOMETRY *****************/
+/********************************************/
+
+bool gpoint_equal(const GPoint * const point_a, const GPoint * const point_b) {
+	return point_a->x == point_b->x && point_a->y == point_b->y;
+}
+
+bool grect_equal(const GRect * const rect_a, const GRect * const rect_b) {
+	return gpoint_equal(&rect_a->origin, &rect_b->origin) && rect_a->size.w == rect_b->size.w
+			&& rect_a->size.h == rect_b->size.h;
+}
+
+bool gcolor_equal(GColor8 color_a, GColor8 color_b) {
+	return color_a.argb == color_b.argb;
+}
+
+/********************************************/
+/******************* MATHS ******************/
+/********************************************/
+
+int32_t atan2_lookup(int16_t y, int16_t x) {
+	int32_t angle = (int32_t)lround(atan2(y, x) * TRIG_MAX_ANGLE / (2 * M_PI));
+	return (angle < 0) ? angle + TRIG_MAX_ANGLE : angle % TRIG_MAX_ANGLE;
+}
+
+/********************************************/
+/****************** LOGGING *****************/
+/********************************************/
+
+void app_log(uint8_t level, const char *filename, int line, const char *fmt, ...) {
+	if (!getenv("SHIM_LOG")) {
+		return;
+	}
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, "%s:%d ", filename, line);
+	vfprintf(stderr, fmt, args);
+	fputc('\n', stderr);
+	va_end(args);
+}
@@ -0,0 +1,1568 @@
+/* host implementations of the SDK's windows, layers, drawing, animations, timers, storage, resources & messages -
+   see shim_app.h. Each SDK object is a host structure plus a block of the simulated heap standing in for what the
+   watch would allocate for it */
+#include <math.h>
+#include <pebble.h>
+#include "shim_heap.h"
+#include "shim_app.h"
+
+/********************************************/
+/*************** DECLARATIONS ***************/
+/********************************************/
+
+#define SCREEN_WIDTH 144
+#define SCREEN_HEIGHT 168
+#define MAX_WINDOWS 8
+#define MAX_PERSIST_KEYS 64
+#define MAX_TUPLES 4
+#define START_SECONDS 1700000000
+
+struct Layer {
+	GRect frame;
+	GRect bounds;
+	Layer *parent;
+	Layer *children;
+	Layer *next;
+	LayerUpdateProc update;
+	bool hidden;
+	bool clips;
+	TextLayer *text;
+	void *charge;
+};
+
+struct TextLayer {
+	Layer layer;
+	const char *text;
+	GColor background;
+	GColor colour;
+	GFont font;
+	GTextAlignment alignment;
+};
+
+struct Window {
+	Layer *root;
+	WindowHandlers handlers;
+	GColor background;
+	ClickConfigProvider clickConfig;
+	void *clickContext;
+	bool loaded;
+	void *charge;
+};
+
+struct GBitmap {
+	GSize size;
+	GBitmapFormat format;
+	uint16_t stride;
+	uint8_t *data;
+	void *charge;
+};
+
+struct GContext {
+	GPoint offset;
+	GRect clip;
+	GColor stroke;
+	GColor fill;
+	uint8_t strokeWidth;
+	GCompOp compositing;
+	bool captured;
+};
+
+struct GFont_ {
+	const char *key;
+	int charWidth;
+	int lineHeight;
+};
+
+/* animations & timers are handed out as ids, like the SDK's handles - a stale one is harmless, and never
+   matches one made later */
+typedef struct ShimAnimation {
+	uintptr_t id;
+	const AnimationImplementation *implementation;
+	AnimationHandlers handlers;
+	void *context;
+	uint32_t duration;
+	uint32_t delay;
+	uint32_t start;
+	bool scheduled;
+	bool started;
+	Layer *layer;
+	bool hasFrom;
+	GRect from;
+	GRect to;
+	void *charge;
+	struct ShimAnimation *next;
+} ShimAnimation;
+
+typedef struct ShimTimer {
+	uintptr_t id;
+	uint32_t deadline;
+	AppTimerCallback callback;
+	void *data;
+	void *charge;
+	struct ShimTimer *next;
+} ShimTimer;
+
+struct DictionaryIterator {
+	Tuple *tuples[MAX_TUPLES];
+	int count;
+};
+
+typedef struct {
+	uint32_t key;
+	int size;
+	uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+typedef struct {
+	const char *file;
+	uint8_t *bytes;
+	size_t size;
+} Resource;
+
+static uint32_t now = 0;
+static uintptr_t nextId = 1;
+static int framesRendered = 0;
+static bool needsRender = false;
+
+static Window *windowStack[MAX_WINDOWS];
+static int windowCount = 0;
+static ClickHandler singleHandlers[NUM_BUTTONS];
+static ClickHandler longHandlers[NUM_BUTTONS];
+static void *clickContext;
+
+static uint8_t screenPixels[SCREEN_WIDTH * SCREEN_HEIGHT];
+static GBitmap screen = { { SCREEN_WIDTH, SCREEN_HEIGHT }, GBitmapFormat8Bit, SCREEN_WIDTH, screenPixels, NULL };
+static GContext context;
+
+static ShimAnimation *animations = NULL;
+static ShimTimer *timers = NULL;
+
+static PersistEntry persist[MAX_PERSIST_KEYS];
+static int persistCount = 0;
+
+static const char *resourceDir;
+static Resource resources[] = {
+	[RESOURCE_ID_DETAIL_TEXT] = { "detail_text.bin" },
+	[RESOURCE_ID_NAME_INDEX] = { "name_index.bin" },
+	[RESOURCE_ID_DITHERED_DRINKS] = { "dithered_drinks.bin" },
+};
+static int resourceReads = 0;
+static int resourceBytesRead = 0;
+
+static AppMessageInboxReceived inboxReceived;
+static AppMessageInboxDropped inboxDropped;
+static void *messageBuffers;
+static DictionaryIterator inbox;
+static DictionaryIterator outbox;
+
+static BatteryChargeState battery = { 100, false, false };
+
+/* the heap block standing in for an SDK object - the host side works without it, but the app is told it's out of
+   memory, as it would be */
+static void* charge(size_t size, const char *what) {
+	return shim_heap_alloc(size, what);
+}
+
+/********************************************/
+/****************** LAYERS ******************/
+/********************************************/
+
+static void layer_init(Layer *layer, GRect frame) {
+	memset(layer, 0, sizeof(Layer));
+	layer->frame = frame;
+	layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+	layer->clips = true;
+}
+
+Layer* layer_create(GRect frame) {
+	Layer *layer = malloc(sizeof(Layer));
+	void *block = charge(SHIM_LAYER_SIZE, "layer_create");
+	if (!layer || !block) {
+		free(layer);
+		shim_heap_free(block);
+		return NULL;
+	}
+	layer_init(layer, frame);
+	layer->charge = block;
+	return layer;
+}
+
+Layer* layer_create_with_data(GRect frame, size_t data_size) {
+	Layer *layer = malloc(sizeof(Layer));
+	void *block = charge(SHIM_LAYER_SIZE + data_size, "layer_create_with_data");
+	if (!layer || !block) {
+		free(layer);
+		shim_heap_free(block);
+		return NULL;
+	}
+	layer_init(layer, frame);
+	layer->charge = block;
+	memset((uint8_t *)block + SHIM_LAYER_SIZE, 0, data_size);
+	return layer;
+}
+
+void* layer_get_data(const Layer *layer) {
+	return (uint8_t *)layer->charge + SHIM_LAYER_SIZE;
+}
+
+void layer_remove_from_parent(Layer *child) {
+	if (!child || !child->parent) {
+		return;
+	}
+	for (Layer **link = &child->parent->children; *link; link = &(*link)->next) {
+		if (*link == child) {
+			*link = child->next;
+			break;
+		}
+	}
+	child->parent = NULL;
+	child->next = NULL;
+	needsRender = true;
+}
+
+/* children are drawn in order, so the last is on top */
+void layer_add_child(Layer *parent, Layer *child) {
+	layer_remove_from_parent(child);
+	Layer **link = &parent->children;
+	while (*link) {
+		link = &(*link)->next;
+	}
+	*link = child;
+	child->parent = parent;
+	needsRender = true;
+}
+
+void layer_insert_above_sibling(Layer *layer_to_insert, Layer *above_sibling_layer) {
+	if (!above_sibling_layer->parent) {
+		return;
+	}
+	layer_remove_from_parent(layer_to_insert);
+	layer_to_insert->parent = above_sibling_layer->parent;
+	layer_to_insert->next = above_sibling_layer->next;
+	above_sibling_layer->next = layer_to_insert;
+	needsRender = true;
+}
+
+void layer_insert_below_sibling(Layer *layer_to_insert, Layer *below_sibling_layer) {
+	Layer *parent = below_sibling_layer->parent;
+	if (!parent) {
+		return;
+	}
+	layer_remove_from_parent(layer_to_insert);
+	for (Layer **link = &parent->children; *link; link = &(*link)->next) {
+		if (*link == below_sibling_layer) {
+			layer_to_insert->next = below_sibling_layer;
+			*link = layer_to_insert;
+			break;
+		}
+	}
+	layer_to_insert->parent = parent;
+	needsRender = true;
+}
+
+/* a destroyed layer's children are left without a parent, not destroyed */
+static void layer_deinit(Layer *layer) {
+	layer_remove_from_parent(layer);
+	for (Layer *child = layer->children; child;) {
+		Layer *next = child->next;
+		child->parent = NULL;
+		child->next = NULL;
+		child = next;
+	}
+	shim_heap_free(layer->charge);
+}
+
+void layer_destroy(Layer *layer) {
+	if (!layer) {
+		return;
+	}
+	if (layer->text) {
+		fprintf(stderr, "layer_destroy on a text layer's layer\n");
+		abort();
+	}
+	layer_deinit(layer);
+	free(layer);
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+	layer->update = update_proc;
+}
+
+void layer_mark_dirty(Layer *layer) {
+	needsRender = true;
+}
+
+GRect layer_get_frame(const Layer *layer) {
+	return layer->frame;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+	return layer->bounds;
+}
+
+/* as in the SDK, bounds that matched the frame's size follow it */
+void layer_set_frame(Layer *layer, GRect frame) {
+	if (layer->bounds.size.w == layer->frame.size.w && layer->bounds.size.h == layer->frame.size.h) {
+		layer->bounds.size = frame.size;
+	}
+	layer->frame = frame;
+	needsRender = true;
+}
+
+void layer_set_bounds(Layer *layer, GRect bounds) {
+	layer->bounds = bounds;
+	needsRender = true;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+	layer->hidden = hidden;
+	needsRender = true;
+}
+
+bool layer_get_hidden(const Layer *layer) {
+	return layer->hidden;
+}
+
+void layer_set_clips(Layer *layer, bool clips) {
+	layer->clips = clips;
+}
+
+/********************************************/
+/**************** TEXT LAYERS ***************/
+/********************************************/
+
+static void text_layer_update(Layer *layer, GContext *ctx) {
+	TextLayer *text = layer->text;
+	if (text->background.argb != GColorClear.argb) {
+		graphics_context_set_fill_color(ctx, text->background);
+		graphics_fill_rect(ctx, layer->bounds, 0, GCornerNone);
+	}
+	if (text->text) {
+		graphics_draw_text(ctx, text->text, text->font, layer->bounds, GTextOverflowModeWordWrap, text->alignment,
+				NULL);
+	}
+}
+
+TextLayer* text_layer_create(GRect frame) {
+	TextLayer *text = malloc(sizeof(TextLayer));
+	void *block = charge(SHIM_TEXT_LAYER_SIZE, "text_layer_create");
+	if (!text || !block) {
+		free(text);
+		shim_heap_free(block);
+		return NULL;
+	}
+	layer_init(&text->layer, frame);
+	text->layer.charge = block;
+	text->layer.text = text;
+	text->layer.update = text_layer_update;
+	text->text = NULL;
+	text->background = GColorWhite;
+	text->colour = GColorBlack;
+	text->font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+	text->alignment = GTextAlignmentLeft;
+	return text;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+	if (!text_layer) {
+		return;
+	}
+	layer_deinit(&text_layer->layer);
+	free(text_layer);
+}
+
+Layer* text_layer_get_layer(TextLayer *text_layer) {
+	return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+	text_layer->text = text;
+	needsRender = true;
+}
+
+const char* text_layer_get_text(TextLayer *text_layer) {
+	return text_layer->text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+	text_layer->background = color;
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+	text_layer->colour = color;
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+	text_layer->font = font;
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+	text_layer->alignment = text_alignment;
+}
+
+GSize text_layer_get_content_size(TextLayer *text_layer) {
+	return graphics_text_layout_get_content_size(text_layer->text ? text_layer->text : "", text_layer->font,
+			text_layer->layer.bounds, GTextOverflowModeWordWrap, text_layer->alignment);
+}
+
+void text_layer_set_size(TextLayer *text_layer, const GSize max_size) {
+	layer_set_frame(&text_layer->layer, (GRect) { text_layer->layer.frame.origin, max_size });
+}
+
+/********************************************/
+/******************* TEXT *******************/
+/********************************************/
+
+/* text isn't drawn, only measured - every character the same width, so wrapping & paging are realistic */
+static struct GFont_ fonts[] = {
+	{ FONT_KEY_GOTHIC_14, 6, 16 },
+	{ FONT_KEY_GOTHIC_18, 7, 20 },
+	{ FONT_KEY_GOTHIC_24_BOLD, 10, 26 },
+	{ FONT_KEY_GOTHIC_28_BOLD, 12, 30 },
+	{ FONT_KEY_BITHAM_42_BOLD, 25, 44 },
+};
+
+GFont fonts_get_system_font(const char *font_key) {
+	for (unsigned int i = 0; i < ARRAY_LENGTH(fonts); i++) {
+		if (strcmp(fonts[i].key, font_key) == 0) {
+			return &fonts[i];
+		}
+	}
+	return &fonts[0];
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+		const GTextOverflowMode overflow_mode, const GTextAlignment alignment, void *text_attributes) {
+}
+
+/* word wrapped into lines of as many characters as fit - a word too long for a line is broken across lines */
+GSize graphics_text_layout_get_content_size(const char *text, GFont const font, const GRect box,
+		const GTextOverflowMode overflow_mode, const GTextAlignment alignment) {
+	int columns = (box.size.w / font->charWidth > 0) ? box.size.w / font->charWidth : 1;
+	int lines = 0;
+	int line = 0;
+	int widest = 0;
+	const char *c = text;
+	while (*c) {
+		if (*c == '\n') {
+			lines += (line == 0) ? 1 : 0;
+			line = 0;
+			c++;
+			continue;
+		}
+		if (*c == ' ') {
+			c++;
+			continue;
+		}
+		int word = 0;
+		while (c[word] && c[word] != ' ' && c[word] != '\n') {
+			word++;
+		}
+		if (line > 0 && line + 1 + word <= columns) {
+			line += 1 + word;
+		} else {
+			lines += (word + columns - 1) / columns;
+			line = (word - 1) % columns + 1;
+		}
+		widest = (line > widest) ? line : widest;
+		c += word;
+	}
+	int height = lines * font->lineHeight;
+	return GSize(widest * font->charWidth, (height < box.size.h) ? height : box.size.h);
+}
+
+/********************************************/
+/***************** DRAWING ******************/
+/********************************************/
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+	ctx->stroke = color;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+	ctx->fill = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+}
+
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width) {
+	ctx->strokeWidth = stroke_width ? stroke_width : 1;
+}
+
+void graphics_context_set_antialiased(GContext *ctx, bool enable) {
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+	ctx->compositing = mode;
+}
+
+/* a pixel in layer coordinates - drawing is ignored while the frame buffer is captured, as on the watch */
+static void plot(GContext *ctx, int x, int y, GColor colour) {
+	x += ctx->offset.x;
+	y += ctx->offset.y;
+	if (ctx->captured || x < ctx->clip.origin.x || y < ctx->clip.origin.y || x >= ctx->clip.origin.x + ctx->clip.size.w
+			|| y >= ctx->clip.origin.y + ctx->clip.size.h) {
+		return;
+	}
+	screenPixels[y * SCREEN_WIDTH + x] = colour.argb | 0xC0;
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+	for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; y++) {
+		for (int x = rect.origin.x; x < rect.origin.x + rect.size.w; x++) {
+			plot(ctx, x, y, ctx->fill);
+		}
+	}
+}
+
+void graphics_draw_pixel(GContext *ctx, GPoint point) {
+	plot(ctx, point.x, point.y, ctx->stroke);
+}
+
+/* a dot the width of the stroke, centred on a point of a line */
+static void stroke_dot(GContext *ctx, int x, int y) {
+	int width = ctx->strokeWidth;
+	if (width <= 1) {
+		plot(ctx, x, y, ctx->stroke);
+		return;
+	}
+	float radius = width / 2.0f;
+	for (int dy = -width / 2; dy <= width / 2; dy++) {
+		for (int dx = -width / 2; dx <= width / 2; dx++) {
+			if (dx * dx + dy * dy <= radius * radius) {
+				plot(ctx, x + dx, y + dy, ctx->stroke);
+			}
+		}
+	}
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+	int dx = abs(p1.x - p0.x);
+	int dy = -abs(p1.y - p0.y);
+	int sx = (p0.x < p1.x) ? 1 : -1;
+	int sy = (p0.y < p1.y) ? 1 : -1;
+	int error = dx + dy;
+	int x = p0.x;
+	int y = p0.y;
+	while (true) {
+		stroke_dot(ctx, x, y);
+		if (x == p1.x && y == p1.y) {
+			break;
+		}
+		int twice = 2 * error;
+		if (twice >= dy) {
+			error += dy;
+			x += sx;
+		}
+		if (twice <= dx) {
+			error += dx;
+			y += sy;
+		}
+	}
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+	uint8_t width = ctx->strokeWidth;
+	ctx->strokeWidth = 1;
+	int right = rect.origin.x + rect.size.w - 1;
+	int bottom = rect.origin.y + rect.size.h - 1;
+	graphics_draw_line(ctx, rect.origin, GPoint(right, rect.origin.y));
+	graphics_draw_line(ctx, GPoint(right, rect.origin.y), GPoint(right, bottom));
+	graphics_draw_line(ctx, GPoint(right, bottom), GPoint(rect.origin.x, bottom));
+	graphics_draw_line(ctx, GPoint(rect.origin.x, bottom), rect.origin);
+	ctx->strokeWidth = width;
+}
+
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius) {
+	float half = ctx->strokeWidth / 2.0f;
+	int reach = radius + ctx->strokeWidth;
+	for (int y = -reach; y <= reach; y++) {
+		for (int x = -reach; x <= reach; x++) {
+			if (fabsf(sqrtf(x * x + y * y) - radius) <= half) {
+				plot(ctx, p.x + x, p.y + y, ctx->stroke);
+			}
+		}
+	}
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+	for (int y = -radius; y <= radius; y++) {
+		for (int x = -radius; x <= radius; x++) {
+			if (x * x + y * y <= radius * radius) {
+				plot(ctx, p.x + x, p.y + y, ctx->fill);
+			}
+		}
+	}
+}
+
+/* 8-bit bitmaps are copied, skipping transparent pixels when compositing with GCompOpSet; 1-bit ones are white
+   where set and black (or nothing, with GCompOpSet) where not */
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+	int width = (rect.size.w < bitmap->size.w) ? rect.size.w : bitmap->size.w;
+	int height = (rect.size.h < bitmap->size.h) ? rect.size.h : bitmap->size.h;
+	for (int y = 0; y < height; y++) {
+		const uint8_t *row = &bitmap->data[y * bitmap->stride];
+		for (int x = 0; x < width; x++) {
+			GColor colour;
+			if (bitmap->format == GBitmapFormat8Bit) {
+				colour.argb = row[x];
+				if (ctx->compositing == GCompOpSet && colour.a == 0) {
+					continue;
+				}
+			} else {
+				bool set = row[x / 8] & (1 << (x % 8));
+				if (!set && ctx->compositing == GCompOpSet) {
+					continue;
+				}
+				colour = set ? GColorWhite : GColorBlack;
+			}
+			plot(ctx, rect.origin.x + x, rect.origin.y + y, colour);
+		}
+	}
+}
+
+/********************************************/
+/****************** PATHS *******************/
+/********************************************/
+
+GPath* gpath_create(const GPathInfo *init) {
+	GPath *path = malloc(sizeof(GPath));
+	if (path) {
+		*path = (GPath) { .num_points = init->num_points, .points = init->points };
+	}
+	return path;
+}
+
+void gpath_destroy(GPath *path) {
+	free(path);
+}
+
+void gpath_move_to(GPath *path, GPoint point) {
+	path->offset = point;
+}
+
+/* even-odd fill, sampling each row through the middle of its pixels */
+void gpath_draw_filled(GContext *ctx, GPath *path) {
+	if (path->num_points < 3) {
+		return;
+	}
+	int top = path->points[0].y;
+	int bottom = top;
+	for (uint32_t i = 1; i < path->num_points; i++) {
+		top = (path->points[i].y < top) ? path->points[i].y : top;
+		bottom = (path->points[i].y > bottom) ? path->points[i].y : bottom;
+	}
+
+	float *crossings = malloc(path->num_points * sizeof(float));
+	if (!crossings) {
+		return;
+	}
+	for (int y = top; y <= bottom; y++) {
+		float sample = y + 0.5f;
+		int count = 0;
+		for (uint32_t i = 0; i < path->num_points; i++) {
+			GPoint a = path->points[i];
+			GPoint b = path->points[(i + 1) % path->num_points];
+			if ((a.y <= sample) != (b.y <= sample)) {
+				crossings[count++] = a.x + (b.x - a.x) * (sample - a.y) / (float)(b.y - a.y);
+			}
+		}
+		for (int i = 1; i < count; i++) {
+			for (int j = i; j > 0 && crossings[j - 1] > crossings[j]; j--) {
+				float swap = crossings[j];
+				crossings[j] = crossings[j - 1];
+				crossings[j - 1] = swap;
+			}
+		}
+		for (int i = 0; i + 1 < count; i += 2) {
+			for (int x = (int)ceilf(crossings[i] - 0.5f); x <= (int)floorf(crossings[i + 1] - 0.5f); x++) {
+				plot(ctx, x + path->offset.x, y + path->offset.y, ctx->fill);
+			}
+		}
+	}
+	free(crossings);
+}
+
+static void draw_outline(GContext *ctx, GPath *path, bool closed) {
+	for (uint32_t i = 0; i + (closed ? 0 : 1) < path->num_points; i++) {
+		GPoint a = path->points[i];
+		GPoint b = path->points[(i + 1) % path->num_points];
+		graphics_draw_line(ctx, GPoint(a.x + path->offset.x, a.y + path->offset.y),
+				GPoint(b.x + path->offset.x, b.y + path->offset.y));
+	}
+}
+
+void gpath_draw_outline(GContext *ctx, GPath *path) {
+	draw_outline(ctx, path, true);
+}
+
+void gpath_draw_outline_open(GContext *ctx, GPath *path) {
+	draw_outline(ctx, path, false);
+}
+
+/********************************************/
+/***************** BITMAPS ******************/
+/********************************************/
+
+GBitmap* graphics_capture_frame_buffer(GContext *ctx) {
+	if (ctx->captured) {
+		return NULL;
+	}
+	ctx->captured = true;
+	return &screen;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+	if (!ctx->captured || buffer != &screen) {
+		return false;
+	}
+	ctx->captured = false;
+	return true;
+}
+
+/* the bitmap's header and pixels are one block of the heap */
+GBitmap* gbitmap_create_blank(GSize size, GBitmapFormat format) {
+	uint16_t stride = (format == GBitmapFormat8Bit) ? size.w : (size.w + 31) / 32 * 4;
+	GBitmap *bitmap = malloc(sizeof(GBitmap));
+	uint8_t *block = charge(SHIM_BITMAP_SIZE + stride * size.h, "gbitmap_create_blank");
+	if (!bitmap || !block) {
+		free(bitmap);
+		shim_heap_free(block);
+		return NULL;
+	}
+	*bitmap = (GBitmap) { size, format, stride, block + SHIM_BITMAP_SIZE, block };
+	memset(bitmap->data, 0, stride * size.h);
+	return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+	if (!bitmap || bitmap == &screen) {
+		return;
+	}
+	shim_heap_free(bitmap->charge);
+	free(bitmap);
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+	return GRect(0, 0, bitmap->size.w, bitmap->size.h);
+}
+
+uint8_t* gbitmap_get_data(const GBitmap *bitmap) {
+	return bitmap->data;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+	return bitmap->stride;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+	return bitmap->format;
+}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y) {
+	return (GBitmapDataRowInfo) { &bitmap->data[y * bitmap->stride], 0, bitmap->size.w - 1 };
+}
+
+/********************************************/
+/****************** WINDOWS *****************/
+/********************************************/
+
+Window* window_create(void) {
+	Window *window = calloc(1, sizeof(Window));
+	void *block = charge(SHIM_WINDOW_SIZE, "window_create");
+	Layer *root = layer_create(GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT));
+	if (!window || !block || !root) {
+		free(window);
+		shim_heap_free(block);
+		layer_destroy(root);
+		return NULL;
+	}
+	window->root = root;
+	window->background = GColorWhite;
+	window->charge = block;
+	return window;
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+	window->handlers = handlers;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+	window->background = background_color;
+}
+
+Layer* window_get_root_layer(const Window *window) {
+	return window->root;
+}
+
+Window* window_stack_get_top_window(void) {
+	return windowCount ? windowStack[windowCount - 1] : NULL;
+}
+
+bool window_stack_contains_window(Window *window) {
+	for (int i = 0; i < windowCount; i++) {
+		if (windowStack[i] == window) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* the top window's click config is (re)applied whenever it changes */
+static void configure_clicks(void) {
+	memset(singleHandlers, 0, sizeof(singleHandlers));
+	memset(longHandlers, 0, sizeof(longHandlers));
+	Window *top = window_stack_get_top_window();
+	if (top && top->clickConfig) {
+		clickContext = top->clickContext ? top->clickContext : top;
+		top->clickConfig(clickContext);
+	}
+}
+
+void window_set_click_config_provider_with_context(Window *window, ClickConfigProvider click_config_provider,
+		void *context) {
+	window->clickConfig = click_config_provider;
+	window->clickContext = context;
+	if (window == window_stack_get_top_window()) {
+		configure_clicks();
+	}
+}
+
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider) {
+	window_set_click_config_provider_with_context(window, click_config_provider, NULL);
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+	singleHandlers[button_id] = handler;
+}
+
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms, ClickHandler handler) {
+	singleHandlers[button_id] = handler;
+}
+
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler,
+		ClickHandler up_handler) {
+	longHandlers[button_id] = down_handler ? down_handler : up_handler;
+}
+
+void window_stack_push(Window *window, bool animated) {
+	Window *covered = window_stack_get_top_window();
+	if (windowCount == MAX_WINDOWS || window_stack_contains_window(window)) {
+		return;
+	}
+	if (covered && covered->handlers.disappear) {
+		covered->handlers.disappear(covered);
+	}
+	windowStack[windowCount++] = window;
+	if (!window->loaded) {
+		window->loaded = true;
+		if (window->handlers.load) {
+			window->handlers.load(window);
+		}
+	}
+	if (window->handlers.appear) {
+		window->handlers.appear(window);
+	}
+	configure_clicks();
+	needsRender = true;
+}
+
+/* take a window off the stack, unloading it - the one under it (if it was on top) appears again */
+static void window_stack_remove(Window *window) {
+	int i = 0;
+	while (i < windowCount && windowStack[i] != window) {
+		i++;
+	}
+	if (i == windowCount) {
+		return;
+	}
+	bool wasTop = (i == windowCount - 1);
+	memmove(&windowStack[i], &windowStack[i + 1], (windowCount - i - 1) * sizeof(Window *));
+	windowCount--;
+	if (wasTop && window->handlers.disappear) {
+		window->handlers.disappear(window);
+	}
+	if (window->loaded) {
+		window->loaded = false;
+		if (window->handlers.unload) {
+			window->handlers.unload(window);
+		}
+	}
+	Window *top = window_stack_get_top_window();
+	if (wasTop && top && top->handlers.appear) {
+		top->handlers.appear(top);
+	}
+	configure_clicks();
+	needsRender = true;
+}
+
+Window* window_stack_pop(bool animated) {
+	Window *top = window_stack_get_top_window();
+	if (top) {
+		window_stack_remove(top);
+	}
+	return top;
+}
+
+void window_destroy(Window *window) {
+	if (!window) {
+		return;
+	}
+	window_stack_remove(window);
+	layer_destroy(window->root);
+	shim_heap_free(window->charge);
+	free(window);
+}
+
+bool shim_press(ButtonId button, bool longPress) {
+	ClickHandler handler = longPress ? longHandlers[button] : singleHandlers[button];
+	if (handler) {
+		handler(NULL, clickContext);
+		return true;
+	}
+	if (!longPress && button == BUTTON_ID_BACK && windowCount) {
+		window_stack_pop(true);
+		return true;
+	}
+	return false;
+}
+
+/********************************************/
+/***************** RENDERING ****************/
+/********************************************/
+
+static GRect intersect(GRect a, GRect b) {
+	int left = (a.origin.x > b.origin.x) ? a.origin.x : b.origin.x;
+	int top = (a.origin.y > b.origin.y) ? a.origin.y : b.origin.y;
+	int right = (a.origin.x + a.size.w < b.origin.x + b.size.w) ? a.origin.x + a.size.w : b.origin.x + b.size.w;
+	int bottom = (a.origin.y + a.size.h < b.origin.y + b.size.h) ? a.origin.y + a.size.h : b.origin.y + b.size.h;
+	return GRect(left, top, (right > left) ? right - left : 0, (bottom > top) ? bottom - top : 0);
+}
+
+/* each layer draws with a fresh context, offset to where it is on screen and clipped to it */
+static void render_layer(Layer *layer, GPoint parentOrigin, GRect clip) {
+	if (layer->hidden) {
+		return;
+	}
+	GPoint origin = GPoint(parentOrigin.x + layer->frame.origin.x, parentOrigin.y + layer->frame.origin.y);
+	if (layer->clips) {
+		clip = intersect(clip, GRect(origin.x, origin.y, layer->frame.size.w, layer->frame.size.h));
+	}
+	if (layer->update) {
+		context = (GContext) {
+			.offset = GPoint(origin.x + layer->bounds.origin.x, origin.y + layer->bounds.origin.y),
+			.clip = clip,
+			.stroke = GColorBlack,
+			.fill = GColorBlack,
+			.strokeWidth = 1,
+			.compositing = GCompOpAssign,
+		};
+		layer->update(layer, &context);
+		if (context.captured) {
+			fprintf(stderr, "frame buffer still captured after a layer's update\n");
+			abort();
+		}
+	}
+	for (Layer *child = layer->children; child; child = child->next) {
+		render_layer(child, origin, clip);
+	}
+}
+
+static void render(void) {
+	Window *top = window_stack_get_top_window();
+	needsRender = false;
+	if (!top) {
+		return;
+	}
+	memset(screenPixels, top->background.argb | 0xC0, sizeof(screenPixels));
+	render_layer(top->root, GPointZero, GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT));
+	framesRendered++;
+}
+
+int shim_frames_rendered(void) {
+	return framesRendered;
+}
+
+/********************************************/
+/**************** ANIMATIONS ****************/
+/********************************************/
+
+static ShimAnimation* find_animation(Animation *handle) {
+	for (ShimAnimation *a = animations; a; a = a->next) {
+		if (a->id == (uintptr_t)handle) {
+			return a;
+		}
+	}
+	return NULL;
+}
+
+static ShimAnimation* create_animation(size_t size, const char *what) {
+	ShimAnimation *a = calloc(1, sizeof(ShimAnimation));
+	void *block = charge(size, what);
+	if (!a || !block) {
+		free(a);
+		shim_heap_free(block);
+		return NULL;
+	}
+	a->id = nextId++;
+	a->duration = 250;
+	a->charge = block;
+	a->next = animations;
+	animations = a;
+	return a;
+}
+
+Animation* animation_create(void) {
+	ShimAnimation *a = create_animation(SHIM_ANIMATION_SIZE, "animation_create");
+	return a ? (Animation *)a->id : NULL;
+}
+
+static void free_animation(ShimAnimation *a) {
+	for (ShimAnimation **link = &animations; *link; link = &(*link)->next) {
+		if (*link == a) {
+			*link = a->next;
+			break;
+		}
+	}
+	shim_heap_free(a->charge);
+	free(a);
+}
+
+/* stop a scheduled animation - it's destroyed afterwards unless the stopped handler schedules it again */
+static void stop_animation(ShimAnimation *a, bool finished) {
+	uintptr_t id = a->id;
+	a->scheduled = false;
+	if (a->started && a->implementation && a->implementation->teardown) {
+		a->implementation->teardown((Animation *)id);
+	}
+	if (a->handlers.stopped) {
+		a->handlers.stopped((Animation *)id, finished, a->context);
+	}
+	a = find_animation((Animation *)id);
+	if (a && !a->scheduled) {
+		free_animation(a);
+	}
+}
+
+bool animation_destroy(Animation *animation) {
+	ShimAnimation *a = find_animation(animation);
+	if (!a) {
+		return false;
+	}
+	if (a->scheduled) {
+		stop_animation(a, false);
+	} else {
+		free_animation(a);
+	}
+	return true;
+}
+
+bool animation_set_implementation(Animation *animation, const AnimationImplementation *implementation) {
+	ShimAnimation *a = find_animation(animation);
+	if (a) {
+		a->implementation = implementation;
+	}
+	return a != NULL;
+}
+
+bool animation_set_duration(Animation *animation, uint32_t duration_ms) {
+	ShimAnimation *a = find_animation(animation);
+	if (a) {
+		a->duration = duration_ms;
+	}
+	return a != NULL;
+}
+
+bool animation_set_delay(Animation *animation, uint32_t delay_ms) {
+	ShimAnimation *a = find_animation(animation);
+	if (a) {
+		a->delay = delay_ms;
+	}
+	return a != NULL;
+}
+
+bool animation_set_handlers(Animation *animation, AnimationHandlers callbacks, void *context) {
+	ShimAnimation *a = find_animation(animation);
+	if (a) {
+		a->handlers = callbacks;
+		a->context = context;
+	}
+	return a != NULL;
+}
+
+void* animation_get_context(Animation *animation) {
+	ShimAnimation *a = find_animation(animation);
+	return a ? a->context : NULL;
+}
+
+bool animation_schedule(Animation *animation) {
+	ShimAnimation *a = find_animation(animation);
+	if (!a) {
+		return false;
+	}
+	a->scheduled = true;
+	a->started = false;
+	a->start = now;
+	return true;
+}
+
+bool animation_unschedule(Animation *animation) {
+	ShimAnimation *a = find_animation(animation);
+	if (!a || !a->scheduled) {
+		return false;
+	}
+	stop_animation(a, false);
+	return true;
+}
+
+bool animation_is_scheduled(Animation *animation) {
+	ShimAnimation *a = find_animation(animation);
+	return a && a->scheduled;
+}
+
+PropertyAnimation* property_animation_create_layer_frame(Layer *layer, GRect *from_frame, GRect *to_frame) {
+	ShimAnimation *a = create_animation(SHIM_PROPERTY_ANIMATION_SIZE, "property_animation_create_layer_frame");
+	if (!a) {
+		return NULL;
+	}
+	a->layer = layer;
+	a->hasFrom = (from_frame != NULL);
+	a->from = from_frame ? *from_frame : layer->frame;
+	a->to = to_frame ? *to_frame : layer->frame;
+	return (PropertyAnimation *)a->id;
+}
+
+void property_animation_destroy(PropertyAnimation *property_animation) {
+	animation_destroy((Animation *)property_animation);
+}
+
+Animation* property_animation_get_animation(PropertyAnimation *property_animation) {
+	return (Animation *)property_animation;
+}
+
+static int lerp(int from, int to, AnimationProgress progress) {
+	return from + (to - from) * (int64_t)progress / ANIMATION_NORMALIZED_MAX;
+}
+
+/* one frame of every scheduled animation - handlers can schedule, unschedule & destroy any of them, so each is
+   looked up again by id before it's touched */
+static void tick_animations(void) {
+	int count = 0;
+	for (ShimAnimation *a = animations; a; a = a->next) {
+		count++;
+	}
+	uintptr_t *ids = malloc((count ? count : 1) * sizeof(uintptr_t));
+	count = 0;
+	for (ShimAnimation *a = animations; a; a = a->next) {
+		ids[count++] = a->id;
+	}
+
+	for (int i = count - 1; i >= 0; i--) {
+		ShimAnimation *a = find_animation((Animation *)ids[i]);
+		if (!a || !a->scheduled || now < a->start + a->delay) {
+			continue;
+		}
+		if (!a->started) {
+			a->started = true;
+			if (a->layer && !a->hasFrom) {
+				a->from = a->layer->frame;
+			}
+			if (a->implementation && a->implementation->setup) {
+				a->implementation->setup((Animation *)ids[i]);
+			}
+			if (a->handlers.started) {
+				a->handlers.started((Animation *)ids[i], a->context);
+				if (!(a = find_animation((Animation *)ids[i])) || !a->scheduled) {
+					continue;
+				}
+			}
+		}
+		uint32_t elapsed = now - a->start - a->delay;
+		AnimationProgress progress = (a->duration == 0 || elapsed >= a->duration) ? ANIMATION_NORMALIZED_MAX
+				: (AnimationProgress)((uint64_t)elapsed * ANIMATION_NORMALIZED_MAX / a->duration);
+		if (a->layer) {
+			layer_set_frame(a->layer, GRect(lerp(a->from.origin.x, a->to.origin.x, progress),
+					lerp(a->from.origin.y, a->to.origin.y, progress), lerp(a->from.size.w, a->to.size.w, progress),
+					lerp(a->from.size.h, a->to.size.h, progress)));
+		} else if (a->implementation && a->implementation->update) {
+			a->implementation->update((Animation *)ids[i], progress);
+		}
+		if (!(a = find_animation((Animation *)ids[i])) || !a->scheduled) {
+			continue;
+		}
+		if (progress == ANIMATION_NORMALIZED_MAX) {
+			stop_animation(a, true);
+		}
+	}
+	free(ids);
+}
+
+int shim_animations_scheduled(void) {
+	int count = 0;
+	for (ShimAnimation *a = animations; a; a = a->next) {
+		count += a->scheduled ? 1 : 0;
+	}
+	return count;
+}
+
+/********************************************/
+/****************** TIMERS ******************/
+/********************************************/
+
+static ShimTimer* find_timer(AppTimer *handle) {
+	for (ShimTimer *t = timers; t; t = t->next) {
+		if (t->id == (uintptr_t)handle) {
+			return t;
+		}
+	}
+	return NULL;
+}
+
+static void free_timer(ShimTimer *timer) {
+	for (ShimTimer **link = &timers; *link; link = &(*link)->next) {
+		if (*link == timer) {
+			*link = timer->next;
+			break;
+		}
+	}
+	shim_heap_free(timer->charge);
+	free(timer);
+}
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+	ShimTimer *timer = calloc(1, sizeof(ShimTimer));
+	void *block = charge(SHIM_TIMER_SIZE, "app_timer_register");
+	if (!timer || !block) {
+		free(timer);
+		shim_heap_free(block);
+		return NULL;
+	}
+	*timer = (ShimTimer) { nextId++, now + timeout_ms, callback, callback_data, block, timers };
+	timers = timer;
+	return (AppTimer *)timer->id;
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+	ShimTimer *timer = find_timer(timer_handle);
+	if (timer) {
+		timer->deadline = now + new_timeout_ms;
+	}
+	return timer != NULL;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+	ShimTimer *timer = find_timer(timer_handle);
+	if (timer) {
+		free_timer(timer);
+	}
+}
+
+/* fire every timer that's due, earliest first - including any they register that are due already */
+static void fire_timers(void) {
+	while (true) {
+		ShimTimer *due = NULL;
+		for (ShimTimer *t = timers; t; t = t->next) {
+			if (t->deadline <= now && (!due || t->deadline <= due->deadline)) {
+				due = t;
+			}
+		}
+		if (!due) {
+			return;
+		}
+		AppTimerCallback callback = due->callback;
+		void *data = due->data;
+		free_timer(due);
+		callback(data);
+	}
+}
+
+int shim_timers_pending(void) {
+	int count = 0;
+	for (ShimTimer *t = timers; t; t = t->next) {
+		count++;
+	}
+	return count;
+}
+
+/********************************************/
+/******************* TIME *******************/
+/********************************************/
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+	if (tloc) {
+		*tloc = START_SECONDS + now / 1000;
+	}
+	if (out_ms) {
+		*out_ms = now % 1000;
+	}
+	return now % 1000;
+}
+
+uint32_t shim_now(void) {
+	return now;
+}
+
+/* frames while anything's animating, otherwise straight to the next timer - painting whenever something's dirty */
+void shim_run(uint32_t ms) {
+	uint32_t end = now + ms;
+	if (needsRender) {
+		render();
+	}
+	while (now < end) {
+		uint32_t next = end;
+		if (shim_animations_scheduled()) {
+			next = (now + SHIM_FRAME_MS < end) ? now + SHIM_FRAME_MS : end;
+		}
+		for (ShimTimer *t = timers; t; t = t->next) {
+			next = (t->deadline > now && t->deadline < next) ? t->deadline : next;
+		}
+		now = next;
+		fire_timers();
+		tick_animations();
+		if (needsRender) {
+			render();
+		}
+	}
+}
+
+/********************************************/
+/****************** STORAGE *****************/
+/********************************************/
+
+static PersistEntry* find_persist(uint32_t key) {
+	for (int i = 0; i < persistCount; i++) {
+		if (persist[i].key == key) {
+			return &persist[i];
+		}
+	}
+	return NULL;
+}
+
+static PersistEntry* write_persist(uint32_t key, const void *data, size_t size) {
+	PersistEntry *entry = find_persist(key);
+	if (!entry) {
+		if (persistCount == MAX_PERSIST_KEYS) {
+			return NULL;
+		}
+		entry = &persist[persistCount++];
+		entry->key = key;
+	}
+	entry->size = (size < PERSIST_DATA_MAX_LENGTH) ? size : PERSIST_DATA_MAX_LENGTH;
+	memcpy(entry->data, data, entry->size);
+	return entry;
+}
+
+bool persist_exists(const uint32_t key) {
+	return find_persist(key) != NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+	PersistEntry *entry = find_persist(key);
+	return entry ? entry->size : E_DOES_NOT_EXIST;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+	PersistEntry *entry = find_persist(key);
+	int32_t value = 0;
+	if (entry && entry->size == sizeof(value)) {
+		memcpy(&value, entry->data, sizeof(value));
+	}
+	return value;
+}
+
+status_t persist_write_int(const uint32_t key, const int32_t value) {
+	return write_persist(key, &value, sizeof(value)) ? (status_t)sizeof(value) : E_DOES_NOT_EXIST;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+	PersistEntry *entry = find_persist(key);
+	if (!entry) {
+		return E_DOES_NOT_EXIST;
+	}
+	int size = ((size_t)entry->size < buffer_size) ? entry->size : (int)buffer_size;
+	memcpy(buffer, entry->data, size);
+	return size;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+	PersistEntry *entry = write_persist(key, data, size);
+	return entry ? entry->size : E_DOES_NOT_EXIST;
+}
+
+status_t persist_delete(const uint32_t key) {
+	PersistEntry *entry = find_persist(key);
+	if (!entry) {
+		return E_DOES_NOT_EXIST;
+	}
+	*entry = persist[--persistCount];
+	return S_SUCCESS;
+}
+
+/********************************************/
+/***************** RESOURCES ****************/
+/********************************************/
+
+/* resources are in flash on the watch, so they're read into the host's memory rather than the heap */
+ResHandle resource_get_handle(uint32_t resource_id) {
+	if (resource_id >= ARRAY_LENGTH(resources) || !resources[resource_id].file) {
+		return NULL;
+	}
+	Resource *resource = &resources[resource_id];
+	if (!resource->bytes) {
+		char path[512];
+		snprintf(path, sizeof(path), "%s/%s", resourceDir, resource->file);
+		FILE *f = fopen(path, "rb");
+		if (!f) {
+			fprintf(stderr, "can't open resource %s\n", path);
+			exit(2);
+		}
+		fseek(f, 0, SEEK_END);
+		resource->size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		resource->bytes = malloc(resource->size);
+		if (!resource->bytes || fread(resource->bytes, 1, resource->size, f) != resource->size) {
+			fprintf(stderr, "can't read resource %s\n", path);
+			exit(2);
+		}
+		fclose(f);
+	}
+	return resource;
+}
+
+size_t resource_size(ResHandle h) {
+	return h ? ((Resource *)h)->size : 0;
+}
+
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t *buffer, size_t num_bytes) {
+	Resource *resource = h;
+	if (!resource || start_offset >= resource->size) {
+		return 0;
+	}
+	size_t size = (num_bytes < resource->size - start_offset) ? num_bytes : resource->size - start_offset;
+	memcpy(buffer, &resource->bytes[start_offset], size);
+	resourceReads++;
+	resourceBytesRead += size;
+	return size;
+}
+
+int shim_resource_reads(void) {
+	return resourceReads;
+}
+
+int shim_resource_bytes_read(void) {
+	return resourceBytesRead;
+}
+
+size_t resource_load(ResHandle h, uint8_t *buffer, size_t max_length) {
+	return resource_load_byte_range(h, 0, buffer, max_length);
+}
+
+/********************************************/
+/***************** MESSAGES *****************/
+/********************************************/
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+	AppMessageInboxReceived previous = inboxReceived;
+	inboxReceived = received_callback;
+	return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+	AppMessageInboxDropped previous = inboxDropped;
+	inboxDropped = dropped_callback;
+	return previous;
+}
+
+/* the inbox & outbox buffers come out of the app heap, for as long as the app runs */
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+	if (!messageBuffers) {
+		messageBuffers = charge(size_inbound + size_outbound, "app_message_open");
+	}
+	return messageBuffers ? APP_MSG_OK : APP_MSG_BUSY;
+}
+
+uint32_t app_message_inbox_size_maximum(void) {
+	return 8200;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+	outbox.count = 0;
+	*iterator = &outbox;
+	return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+	return APP_MSG_OK;
+}
+
+int dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) {
+	return 0;
+}
+
+Tuple* dict_find(const DictionaryIterator *iter, const uint32_t key) {
+	for (int i = 0; i < iter->count; i++) {
+		if (iter->tuples[i]->key == key) {
+			return iter->tuples[i];
+		}
+	}
+	return NULL;
+}
+
+void shim_message_begin(void) {
+	for (int i = 0; i < inbox.count; i++) {
+		free(inbox.tuples[i]);
+	}
+	inbox.count = 0;
+}
+
+void shim_message_add(uint32_t key, const uint8_t *data, uint16_t length) {
+	if (inbox.count == MAX_TUPLES) {
+		return;
+	}
+	Tuple *tuple = malloc(sizeof(Tuple) + length);
+	tuple->key = key;
+	tuple->type = TUPLE_BYTE_ARRAY;
+	tuple->length = length;
+	memcpy(tuple->value->data, data, length);
+	inbox.tuples[inbox.count++] = tuple;
+}
+
+void shim_message_deliver(void) {
+	if (inboxReceived) {
+		inboxReceived(&inbox, NULL);
+	}
+	shim_message_begin();
+}
+
+/********************************************/
+/****************** SYSTEM ******************/
+/********************************************/
+
+BatteryChargeState battery_state_service_peek(void) {
+	return battery;
+}
+
+void shim_set_battery(uint8_t percent, bool charging) {
+	battery = (BatteryChargeState) { percent, charging, charging };
+}
+
+void light_enable_interaction(void) {
+}
+
+void shim_app_init(const char *resources) {
+	resourceDir = resources;
+	now = 0;
+	memset(screenPixels, GColorBlack.argb, sizeof(screenPixels));
+}
+
+void shim_app_exit(void) {
+	while (timers) {
+		free_timer(timers);
+	}
+	while (animations) {
+		free_animation(animations);
+	}
+	shim_heap_free(messageBuffers);
+	messageBuffers = NULL;
+}
@@ -0,0 +1,48 @@
+/* the host side of the SDK shim - what a harness uses to drive an app built against pebble.h: pressing buttons,
+   letting time pass (timers fire, animations run, the top window repaints into a frame buffer) and sending
+   messages from the phone. Time is simulated, so a run takes as long as its drawing does */
+#pragma once
+#include <pebble.h>
+
+/* the SDK objects' own allocations on the watch, charged to the simulated heap in their place - approximate
+   sizes for SDK 3, as the host's own structures are bigger */
+#define SHIM_WINDOW_SIZE 112
+#define SHIM_LAYER_SIZE 48
+#define SHIM_TEXT_LAYER_SIZE 88
+#define SHIM_ANIMATION_SIZE 68
+#define SHIM_PROPERTY_ANIMATION_SIZE 100
+#define SHIM_TIMER_SIZE 32
+#define SHIM_BITMAP_SIZE 32
+
+/* a frame every 33 ms while anything is animating, as on the watch */
+#define SHIM_FRAME_MS 33
+
+/* set up the screen, clock & storage; resources are read from resourceDir */
+void shim_app_init(const char *resourceDir);
+
+/* what the system frees when the app exits - timers & animations still pending, and the message buffers - so
+   anything left on the heap after it is the app's own */
+void shim_app_exit(void);
+
+/* press a button on the top window, long or not - false if the window has nothing for it. Back with nothing
+   subscribed pops the window, as on the watch */
+bool shim_press(ButtonId button, bool longPress);
+
+/* let ms pass - timers fire, animations run and the top window repaints whenever anything's been marked dirty */
+void shim_run(uint32_t ms);
+
+uint32_t shim_now(void);
+int shim_frames_rendered(void);
+int shim_animations_scheduled(void);
+int shim_timers_pending(void);
+
+void shim_set_battery(uint8_t percent, bool charging);
+
+/* resource reads so far, and the bytes they read - reads from flash are what a lookup costs on the watch */
+int shim_resource_reads(void);
+int shim_resource_bytes_read(void);
+
+/* a message from the phone, built a tuple at a time and then delivered to the inbox handler */
+void shim_message_begin(void);
+void shim_message_add(uint32_t key, const uint8_t *data, uint16_t length);
+void shim_message_deliver(void);
@@ -0,0 +1,199 @@
+/* the simulated app heap - see shim_heap.h */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shim_heap.h"
+
+/********************************************/
+/*************** DECLARATIONS ***************/
+/********************************************/
+
+/* blocks are a header then the allocation, in multiples of ALIGNMENT - the header is the size of the watch's,
+   so the overhead per allocation matches */
+#define ALIGNMENT 8
+#define HEADER_SIZE 8
+
+typedef struct {
+	uint32_t size;
+	uint32_t allocated;
+} BlockHeader;
+
+/* where each live block was allocated from, kept beside the heap rather than in it so the heap's layout isn't
+   changed by it - indexed by block offset / ALIGNMENT */
+typedef struct {
+	const char *file;
+	int line;
+} BlockSite;
+
+static uint8_t *arena = NULL;
+static size_t arenaSize = 0;
+static BlockSite *sites = NULL;
+static HeapStats stats;
+
+static BlockHeader* block_at(size_t offset) {
+	return (BlockHeader *)&arena[offset];
+}
+
+static size_t round_up(size_t size) {
+	return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/********************************************/
+/***************** THE HEAP *****************/
+/********************************************/
+
+void shim_heap_init(size_t size) {
+	free(arena);
+	free(sites);
+	arenaSize = size / ALIGNMENT * ALIGNMENT;
+	arena = malloc(arenaSize);
+	sites = calloc(arenaSize / ALIGNMENT, sizeof(BlockSite));
+	if (!arena || !sites) {
+		fprintf(stderr, "no memory for a %d byte heap\n", (int)size);
+		exit(2);
+	}
+	*block_at(0) = (BlockHeader) { .size = arenaSize, .allocated = 0 };
+	memset(&stats, 0, sizeof(stats));
+	stats.size = arenaSize;
+}
+
+/* merge a free block with any free blocks straight after it */
+static void merge_following(size_t offset) {
+	BlockHeader *block = block_at(offset);
+	while (offset + block->size < arenaSize && !block_at(offset + block->size)->allocated) {
+		block->size += block_at(offset + block->size)->size;
+	}
+}
+
+static void* allocate(size_t size, const char *file, int line) {
+	size_t needed = HEADER_SIZE + round_up(size ? size : 1);
+	for (size_t offset = 0; offset < arenaSize; offset += block_at(offset)->size) {
+		BlockHeader *block = block_at(offset);
+		if (block->allocated) {
+			continue;
+		}
+		merge_following(offset);
+		if (block->size < needed) {
+			continue;
+		}
+
+		/* split off what's left, if it's enough to be a block of its own */
+		if (block->size - needed >= HEADER_SIZE + ALIGNMENT) {
+			*block_at(offset + needed) = (BlockHeader) { .size = block->size - needed, .allocated = 0 };
+			block->size = needed;
+		}
+		block->allocated = 1;
+		sites[offset / ALIGNMENT] = (BlockSite) { file, line };
+		stats.used += block->size;
+		stats.live_allocations++;
+		stats.peak_used = (stats.used > stats.peak_used) ? stats.used : stats.peak_used;
+		return &arena[offset + HEADER_SIZE];
+	}
+	stats.failed_allocations++;
+	return NULL;
+}
+
+bool shim_heap_owns(const void *ptr) {
+	return arena && (const uint8_t *)ptr >= arena && (const uint8_t *)ptr < arena + arenaSize;
+}
+
+void shim_heap_free(void *ptr) {
+	if (!ptr) {
+		return;
+	}
+	size_t offset = (uint8_t *)ptr - arena - HEADER_SIZE;
+	if (!shim_heap_owns(ptr) || offset % ALIGNMENT || !block_at(offset)->allocated) {
+		fprintf(stderr, "free of %p, which isn't an allocated block\n", ptr);
+		abort();
+	}
+	BlockHeader *block = block_at(offset);
+	block->allocated = 0;
+	stats.used -= block->size;
+	stats.live_allocations--;
+	merge_following(offset);
+}
+
+void* shim_heap_alloc(size_t size, const char *site) {
+	return allocate(size, site, 0);
+}
+
+/********************************************/
+/*************** STATISTICS *****************/
+/********************************************/
+
+HeapStats shim_heap_stats(void) {
+	stats.free = 0;
+	stats.largest_free = 0;
+	stats.free_blocks = 0;
+	for (size_t offset = 0; offset < arenaSize; offset += block_at(offset)->size) {
+		BlockHeader *block = block_at(offset);
+		if (!block->allocated) {
+			merge_following(offset);
+			stats.free += block->size;
+			stats.free_blocks++;
+			if (block->size - HEADER_SIZE > stats.largest_free) {
+				stats.largest_free = block->size - HEADER_SIZE;
+			}
+		}
+	}
+	return stats;
+}
+
+int shim_heap_report_live(void) {
+	int live = 0;
+	for (size_t offset = 0; offset < arenaSize; offset += block_at(offset)->size) {
+		BlockHeader *block = block_at(offset);
+		if (block->allocated) {
+			BlockSite site = sites[offset / ALIGNMENT];
+			if (site.line) {
+				printf("  %5d bytes from %s:%d\n", (int)(block->size - HEADER_SIZE), site.file, site.line);
+			} else {
+				printf("  %5d bytes from %s\n", (int)(block->size - HEADER_SIZE), site.file);
+			}
+			live++;
+		}
+	}
+	return live;
+}
+
+/********************************************/
+/************ THE SOURCES' VIEW *************/
+/********************************************/
+
+size_t heap_bytes_used(void) {
+	return stats.used;
+}
+
+size_t heap_bytes_free(void) {
+	return arenaSize - stats.used;
+}
+
+void* shim_malloc(size_t size, const char *file, int line) {
+	return allocate(size, file, line);
+}
+
+void* shim_calloc(size_t count, size_t size, const char *file, int line) {
+	void *ptr = allocate(count * size, file, line);
+	if (ptr) {
+		memset(ptr, 0, count * size);
+	}
+	return ptr;
+}
+
+void* shim_realloc(void *ptr, size_t size, const char *file, int line) {
+	if (!ptr) {
+		return allocate(size, file, line);
+	}
+	size_t old = block_at((uint8_t *)ptr - arena - HEADER_SIZE)->size - HEADER_SIZE;
+	void *moved = allocate(size, file, line);
+	if (moved) {
+		memcpy(moved, ptr, (old < size) ? old : size);
+		shim_heap_free(ptr);
+	}
+	return moved;
+}
+
+void shim_free(void *ptr) {
+	shim_heap_free(ptr);
+}
@@ -0,0 +1,31 @@
+/* a simulated app heap for host runs - a fixed arena the size of the watch's, allocated first fit with a small
+   header per block and neighbouring free blocks merged, much as the watch's own allocator does. Sources built with
+   SHIM_HEAP allocate from it (see pebble.h), as do the SDK objects shim_app.c makes for them, so fragmentation
+   shows up here the way it would on the watch */
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct {
+	size_t size;
+	size_t used;
+	size_t free;
+	size_t largest_free;
+	int live_allocations;
+	int free_blocks;
+	int failed_allocations;
+	size_t peak_used;
+} HeapStats;
+
+/* (re)create the heap, empty, with size bytes - everything allocated from the old one is gone */
+void shim_heap_init(size_t size);
+
+HeapStats shim_heap_stats(void);
+
+/* print every block still allocated, with where it was allocated from - returns how many there were */
+int shim_heap_report_live(void);
+
+/* allocations from the heap on behalf of the SDK, charged to the calling site as the sources' are */
+void* shim_heap_alloc(size_t size, const char *site);
+void shim_heap_free(void *ptr);
+bool shim_heap_owns(const void *ptr);
@@ -0,0 +1,261 @@
+/* soak test for the app's heap - runs src/main.c with its real handlers against the host shim, pressing buttons in
+   scripted sequences tens of thousands of times: browsing up & down at every pace (so all three transition styles
+   run, and presses land mid-transition), reading detail pages, jumping from the grid and the letter picker, with a
+   sync from the phone now and then - some with the grid or the letter picker open. The heap is the size of the watch's, so fragmentation shows up as it would.
+
+   After each sequence the app is left to settle, and the heap's used & free bytes, largest free block and live
+   allocations are sampled; a row is printed every so often so a trend shows. Fails if an allocation fails, if
+   the settled heap keeps climbing once the caches have filled, or if anything is still allocated after the app
+   exits (each leak is listed with where it was allocated).
+
+   Usage: make -C tools/host soak [SEQUENCES=n] [HEAP_SIZE=bytes] [BW=1 [APLITE_APP_SIZE=bytes]] */
+#include <pebble.h>
+#include "shim_heap.h"
+#include "shim_app.h"
+
+/* the app itself, with its main renamed so this file's can drive it */
+#define main coffee_guru_main
+#include "main.c"
+#undef main
+
+/********************************************/
+/*************** DECLARATIONS ***************/
+/********************************************/
+
+#ifndef SEQUENCES
+#define SEQUENCES 20000
+#endif
+#ifndef HEAP_SIZE
+#define HEAP_SIZE 65536
+#endif
+#ifndef RESOURCE_DIR
+#define RESOURCE_DIR "../../resources/data"
+#endif
+
+/* time left after each sequence for the pour, prefetch & staging to finish */
+#define SETTLE_MS 1500
+#define REPORT_ROWS 20
+#define SYNC_EVERY 997
+#define BATTERY_EVERY 2500
+#define CHUNK_SIZE 64
+
+/* the first part of the run fills the caches (paths, strokes, thumbnails); after it the settled heap shouldn't
+   climb by more than GROWTH_SLACK */
+#define WARM_UP_SEQUENCES (SEQUENCES / 10)
+#define GROWTH_SLACK 256
+
+/* presses are u/d/s/b for up, down, select & back, U/S for long up & long select */
+typedef struct {
+	const char *name;
+	const char *presses;
+} Sequence;
+
+static const Sequence script[] = {
+	{ "up", "u" },
+	{ "down", "d" },
+	{ "skim", "uuuddd" },
+	{ "read", "sddub" },
+	{ "glance", "sb" },
+	{ "grid", "Uddds" },
+	{ "grid & back", "Uuub" },
+	{ "jump", "Sds" },
+	{ "jump & back", "Sub" },
+};
+
+/* gaps between presses - fast enough to cut, reduce or interrupt transitions, and slow enough for full ones */
+static const uint32_t gaps[] = { 60, 150, 350, 600, 1100 };
+
+static const uint8_t batteries[] = { 100, 45, 15 };
+
+/* records to sync, as the phone sends them - name, detail, layers, each after its length */
+static const uint8_t syncRecords[][48] = {
+	{ 5, 'M', 'o', 'c', 'h', 'a', 6, 'C', 'h', 'o', 'c', 'c', 'y', 3,
+			SYNC_LAYER_ESPRESSO_SHOT, SYNC_LAYER_MILK_TO_HIGH, SYNC_LAYER_FOAM_TO_VERY_LOW },
+	{ 7, 'C', 'o', 'r', 't', 'a', 'd', 'o', 4, 'S', 'h', 'o', 't', 2, SYNC_LAYER_ESPRESSO_SHOT, SYNC_LAYER_MILK_TO_LOW },
+	{ 3, 'Z', 'o', 'e', 11, 'N', 'o', 't', ' ', 'a', ' ', 'd', 'r', 'i', 'n', 'k', 1, SYNC_LAYER_WATER_TO_TOP },
+};
+
+/* message keys, as in appinfo.json */
+#define KEY_SYNC_BEGIN 0
+#define KEY_SYNC_CHUNK 1
+#define KEY_SYNC_END 2
+
+static uint32_t seed = 20161;
+static int presses = 0;
+static int syncs = 0;
+static bool failed = false;
+
+static uint32_t random_below(uint32_t limit) {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) % limit;
+}
+
+/********************************************/
+/***************** DRIVING ******************/
+/********************************************/
+
+static void press(char c) {
+	ButtonId buttons[] = { ['u'] = BUTTON_ID_UP, ['d'] = BUTTON_ID_DOWN, ['s'] = BUTTON_ID_SELECT,
+			['b'] = BUTTON_ID_BACK, ['U'] = BUTTON_ID_UP, ['S'] = BUTTON_ID_SELECT };
+	bool longPress = (c == 'U' || c == 'S');
+	shim_press(buttons[(int)c], longPress);
+	presses++;
+}
+
+/* the phone replaces the synced drinks with the first count of syncRecords, streamed in chunks. It starts on the
+   last synced drink, as if the app had been left on it - afterwards it should be back on it if the phone sent it
+   again, or on a built in drink if not. With picker (a long press, U or S) the grid or letter window is open on
+   that drink through the sync, and must be left on one that's still there. False if any of it isn't so */
+static bool sync_drinks(int count, char picker) {
+	char showing[SYNC_NAME_MAX + 1] = "";
+	if (catalog_sync_count() > 0) {
+		graphic_window_jump_to(entry_count() - 1);
+		shim_run(SETTLE_MS);
+		strcpy(showing, header_text(drawingItem[active]));
+	}
+	if (picker) {
+		press(picker);
+		shim_run(SETTLE_MS);
+	}
+
+	uint8_t stream[sizeof(syncRecords)];
+	int length = 0;
+	bool resent = false;
+	for (int i = 0; i < count; i++) {
+		const uint8_t *record = syncRecords[i];
+		resent = resent || (strlen(showing) == record[0] && memcmp(showing, &record[1], record[0]) == 0);
+		int size = 1 + record[0];
+		size += 1 + record[size];
+		size += 1 + record[size];
+		memcpy(&stream[length], record, size);
+		length += size;
+	}
+
+	uint8_t none = 0;
+	shim_message_begin();
+	shim_message_add(KEY_SYNC_BEGIN, &none, 1);
+	shim_message_deliver();
+	for (int at = 0; at < length; at += CHUNK_SIZE) {
+		shim_message_begin();
+		shim_message_add(KEY_SYNC_CHUNK, &stream[at], (length - at < CHUNK_SIZE) ? length - at : CHUNK_SIZE);
+		shim_message_deliver();
+		shim_run(50);
+	}
+	shim_message_begin();
+	shim_message_add(KEY_SYNC_END, &none, 1);
+	shim_message_deliver();
+	shim_run(SETTLE_MS);
+	syncs++;
+
+	if (picker) {
+		int item = (picker == 'U') ? gridSelected : first_entry_in_bucket(letterBucket);
+		if (item < 0 || item >= entry_count()) {
+			printf("sync %d left the %s on drink %d of %d\n", syncs, (picker == 'U') ? "grid" : "letter picker", item,
+					entry_count());
+			return false;
+		}
+		press('b');
+		shim_run(SETTLE_MS);
+	}
+
+	if (resent ? strcmp(header_text(drawingItem[active]), showing) != 0
+			: drawingItem[active] >= entry_count() - catalog_sync_count()) {
+		printf("sync %d started on %s, and ended on %s\n", syncs, showing[0] ? showing : "a built in drink",
+				header_text(drawingItem[active]));
+		return false;
+	}
+	return true;
+}
+
+/********************************************/
+/*************** MEASUREMENT ****************/
+/********************************************/
+
+static void print_header() {
+	printf("%9s %8s %7s %7s %7s %8s %6s %7s %7s\n", "sequence", "presses", "used", "free", "largest", "fragments",
+			"live", "failed", "frames");
+}
+
+static void print_row(int sequence, HeapStats stats) {
+	printf("%9d %8d %7d %7d %7d %8d %6d %7d %7d\n", sequence, presses, (int)stats.used, (int)stats.free,
+			(int)stats.largest_free, stats.free_blocks, stats.live_allocations, stats.failed_allocations,
+			shim_frames_rendered());
+}
+
+/********************************************/
+/***************** THE RUN ******************/
+/********************************************/
+
+/* stands in for the SDK's event loop - the app's been initialised when it's called, and is deinitialised after */
+void app_event_loop(void) {
+	shim_run(SETTLE_MS);
+	print_header();
+
+	size_t warmUsed = 0;
+	size_t laterUsed = 0;
+	size_t smallestLargest = HEAP_SIZE;
+	HeapStats stats = shim_heap_stats();
+	for (int sequence = 1; sequence <= SEQUENCES; sequence++) {
+		if (sequence % BATTERY_EVERY == 0) {
+			shim_set_battery(batteries[sequence / BATTERY_EVERY % ARRAY_LENGTH(batteries)], false);
+		}
+		if (sequence % SYNC_EVERY == 0 && !sync_drinks(1 + syncs % ARRAY_LENGTH(syncRecords),
+				"\0US"[syncs / ARRAY_LENGTH(syncRecords) % 3])) {
+			failed = true;
+			return;
+		}
+
+		const Sequence *next = &script[random_below(ARRAY_LENGTH(script))];
+		for (const char *c = next->presses; *c; c++) {
+			press(*c);
+			shim_run(gaps[random_below(ARRAY_LENGTH(gaps))]);
+		}
+		shim_run(SETTLE_MS);
+
+		if (window_stack_get_top_window() != graphicWindow) {
+			printf("sequence %d (%s) didn't end back on the drawing\n", sequence, next->name);
+			failed = true;
+			return;
+		}
+
+		stats = shim_heap_stats();
+		smallestLargest = (stats.largest_free < smallestLargest) ? stats.largest_free : smallestLargest;
+		if (sequence <= SEQUENCES / 2) {
+			warmUsed = (sequence > WARM_UP_SEQUENCES && stats.used > warmUsed) ? stats.used : warmUsed;
+		} else {
+			laterUsed = (stats.used > laterUsed) ? stats.used : laterUsed;
+		}
+		if (sequence % (SEQUENCES / REPORT_ROWS > 0 ? SEQUENCES / REPORT_ROWS : 1) == 0) {
+			print_row(sequence, stats);
+		}
+	}
+
+	printf("\n%d presses, %d syncs: peak %d of %d bytes used, smallest largest free block %d bytes\n", presses,
+			syncs, (int)stats.peak_used, (int)stats.size, (int)smallestLargest);
+	printf("settled heap: at most %d bytes in the first half after warming up, %d in the second\n", (int)warmUsed,
+			(int)laterUsed);
+	if (stats.failed_allocations) {
+		printf("FAILED: %d allocations failed\n", stats.failed_allocations);
+		failed = true;
+	}
+	if (laterUsed > warmUsed + GROWTH_SLACK) {
+		printf("FAILED: the settled heap climbed by %d bytes\n", (int)(laterUsed - warmUsed));
+		failed = true;
+	}
+}
+
+int main(void) {
+	shim_heap_init(HEAP_SIZE);
+	shim_app_init(RESOURCE_DIR);
+	coffee_guru_main();
+
+	/* the system frees the message buffers when the app exits - anything else is the app's */
+	shim_app_exit();
+	if (shim_heap_stats().live_allocations) {
+		printf("still allocated after exit:\n");
+		printf("FAILED: %d allocations leaked\n", shim_heap_report_live());
+		failed = true;
+	}
+	printf("%s\n", failed ? "FAILED" : "passed");
+	return failed ? 1 : 0;
+}
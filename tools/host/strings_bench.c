@@ -0,0 +1,102 @@
+/* check & time the packed detail text - every string is decoded from resources/data/detail_text.bin with
+   src/string_table.c and compared byte for byte with its literal in src/catalog.h, then the resource's size is set
+   against the literals' and each decode timed against copying the literal out, which is what the plain table
+   would cost. Fails if any string doesn't decode to its literal - a stale resource shows up here, so rerun
+   tools/pack_strings.py after changing the catalog.
+
+   Desktop times are only a guide to the watch's, where the decode's resource reads come from flash.
+
+   Usage: make -C tools/host strings */
+#include <time.h>
+#include <pebble.h>
+#include "shim_app.h"
+#include "string_table.h"
+#include "catalog.h"
+
+#ifndef RESOURCE_DIR
+#define RESOURCE_DIR "../../resources/data"
+#endif
+
+#define REPEATS 20
+#define DECODE_REPEATS 200
+
+/* the catalog's detail text, in drink order */
+#define DRINK_DETAIL(id, header, detail, ...) detail,
+static const char *details[] = { DRINK_CATALOG(DRINK_DETAIL) };
+
+static double now_micros() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static char* decode(int i) {
+	return string_table_decode(RESOURCE_ID_DETAIL_TEXT, i);
+}
+
+/* the plain table's equivalent - the literal copied into a buffer of its own, as the decode's is */
+static char* copy_literal(int i) {
+	size_t length = strlen(details[i]);
+	char *text = malloc(length + 1);
+	if (text) {
+		memcpy(text, details[i], length + 1);
+	}
+	return text;
+}
+
+/* the fastest of repeats passes over every string, per string */
+static double time_strings(char* (*get)(int i)) {
+	double fastest = 0;
+	volatile char sink = 0;
+	for (int r = 0; r < REPEATS; r++) {
+		double started = now_micros();
+		for (int n = 0; n < DECODE_REPEATS; n++) {
+			for (unsigned int i = 0; i < ARRAY_LENGTH(details); i++) {
+				char *text = get(i);
+				sink += text[0];
+				free(text);
+			}
+		}
+		double micros = (now_micros() - started) / (DECODE_REPEATS * ARRAY_LENGTH(details));
+		fastest = (r == 0 || micros < fastest) ? micros : fastest;
+	}
+	return fastest;
+}
+
+int main(void) {
+	shim_app_init(RESOURCE_DIR);
+	int failures = 0;
+
+	int plainBytes = 0;
+	int mostReads = 0;
+	int mostBytes = 0;
+	for (unsigned int i = 0; i < ARRAY_LENGTH(details); i++) {
+		plainBytes += strlen(details[i]) + 1;
+		int reads = shim_resource_reads();
+		int bytes = shim_resource_bytes_read();
+		char *text = decode(i);
+		reads = shim_resource_reads() - reads;
+		bytes = shim_resource_bytes_read() - bytes;
+		mostReads = (reads > mostReads) ? reads : mostReads;
+		mostBytes = (bytes > mostBytes) ? bytes : mostBytes;
+
+		if (!text || strlen(text) != strlen(details[i]) || memcmp(text, details[i], strlen(details[i])) != 0) {
+			failures++;
+			printf("string %d decodes to \"%s\", the catalog has \"%s\"\n", i, text ? text : "(nothing)", details[i]);
+		}
+		free(text);
+	}
+	char *extra = decode(ARRAY_LENGTH(details));
+	if (extra) {
+		failures++;
+		printf("the resource has more strings than the catalog's %d\n", (int)ARRAY_LENGTH(details));
+		free(extra);
+	}
+
+	int packedBytes = resource_size(resource_get_handle(RESOURCE_ID_DETAIL_TEXT));
+	printf("%d strings: %d bytes packed, %d as literals (%.0f%%)\n", (int)ARRAY_LENGTH(details), packedBytes, plainBytes,
+			100.0 * packedBytes / plainBytes);
+	printf("decoding: at most %d reads of %d bytes, %.3f us a string (copying the literal %.3f us) - %s\n", mostReads,
+			mostBytes, time_strings(decode), time_strings(copy_literal), failures ? "FAILED" : "all match");
+	return failures ? 1 : 0;
+}
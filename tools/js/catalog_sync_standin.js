@@ -0,0 +1,165 @@
+/*
+ * Stand-in for a phone side catalog - streams recipes to the watch in small chunks, which src/catalog_sync.c
+ * parses as they arrive and stores a drink at a time. Each chunk waits for the last to be acknowledged, so
+ * the watch never has more than one in hand.
+ *
+ * For testing the sync only - wscript bundles it when CATALOG_SYNC_STANDIN=1 is set in the environment, and
+ * release builds leave it out. It syncs when the app starts only if CATALOG_VERSION has changed since the
+ * watch last stored the catalog, or FORCE_SYNC is set; each sync replaces every synced drink in storage.
+ *
+ * Set SYNTHETIC_DRINKS to add made up drinks after the real ones, to measure throughput - the watch only keeps
+ * as many as it has room for, but parses them all. It logs what it stored, how long it took and its heap peak.
+ */
+
+/* matching the SYNC_LAYER_ numbers in src/catalog_sync.h */
+var LAYER = {
+  ESPRESSO_SHOT: 0,
+  WATER_TO_TOP: 1,
+  FOAM_TO_TOP: 2,
+  MILK_TO_MID: 3,
+  MILK_TO_HIGH: 4,
+  MILK_TO_LOW: 5,
+  FOAM_TO_VERY_LOW: 6
+};
+
+/* bump when RECIPES changes, so watches that have the old ones are sent the new */
+var CATALOG_VERSION = 1;
+var FORCE_SYNC = false;
+var SYNTHETIC_DRINKS = 0;
+
+/* no bigger than the watch's inbox allows */
+var CHUNK_SIZE = 128;
+
+/* the limits src/catalog_sync.c keeps records to - a record is stored in one persist key, and anything bigger
+   is dropped */
+var NAME_MAX = 24;
+var RECORD_MAX = 256;
+var MAX_LAYERS = 6;
+var LAYER_COUNT = 7;
+
+/* layers are painted in order, so the highest level goes first - the same as in src/catalog.h */
+var RECIPES = [
+  {
+    name: 'Cortado',
+    detail: 'An espresso shot cut with a roughly equal amount of warm milk, to take the edge off the acidity',
+    layers: [LAYER.MILK_TO_MID, LAYER.ESPRESSO_SHOT]
+  },
+  {
+    name: 'Flat White',
+    detail: 'A double shot topped with steamed milk and just a thin layer of velvety microfoam',
+    layers: [LAYER.FOAM_TO_VERY_LOW, LAYER.MILK_TO_HIGH, LAYER.ESPRESSO_SHOT]
+  },
+  {
+    name: 'Long Black',
+    detail: 'Hot water with an espresso shot poured on top, keeping the crema - stronger than an americano',
+    layers: [LAYER.WATER_TO_TOP, LAYER.ESPRESSO_SHOT]
+  },
+  {
+    name: 'Piccolo',
+    detail: 'A ristretto shot in a small glass, topped up with a little warm milk',
+    layers: [LAYER.MILK_TO_LOW, LAYER.ESPRESSO_SHOT]
+  }
+];
+
+/* the watch's fonts are ASCII - accents are taken off (é is e and an accent once decomposed), and anything else
+   outside printable ASCII becomes '?' */
+function toAscii(text) {
+  if (text.normalize) {
+    text = text.normalize('NFD').replace(/[\u0300-\u036f]/g, '');
+  }
+  return text.replace(/[^\x20-\x7e]/g, '?');
+}
+
+/* append a string as a length byte then its characters, cut to at most maxLength */
+function appendField(bytes, text, maxLength) {
+  text = text.substring(0, maxLength);
+  bytes.push(text.length);
+  for (var i = 0; i < text.length; i++) {
+    bytes.push(text.charCodeAt(i));
+  }
+}
+
+/* uint8 name length, name, uint8 detail length, detail, uint8 number of layers, layers - names are cut to what
+   the watch shows, and details to whatever fits in the rest of the record. A recipe the watch couldn't paint
+   is left out */
+function encodeRecipes(recipes) {
+  var bytes = [];
+  recipes.forEach(function(recipe) {
+    var name = toAscii(recipe.name).substring(0, NAME_MAX);
+    var detail = toAscii(recipe.detail);
+    var badLayer = recipe.layers.some(function(layer) {
+      return layer !== (layer | 0) || layer < 0 || layer >= LAYER_COUNT;
+    });
+    if (name.length === 0 || recipe.layers.length > MAX_LAYERS || badLayer) {
+      console.log('catalog sync: leaving out "' + recipe.name + '" - it needs a name, and at most ' + MAX_LAYERS +
+          ' known layers');
+      return;
+    }
+
+    appendField(bytes, name, NAME_MAX);
+    appendField(bytes, detail, RECORD_MAX - 3 - name.length - recipe.layers.length);
+    bytes.push(recipe.layers.length);
+    recipe.layers.forEach(function(layer) {
+      bytes.push(layer);
+    });
+  });
+  return bytes;
+}
+
+function syntheticRecipes(count) {
+  var recipes = [];
+  for (var i = 0; i < count; i++) {
+    recipes.push({
+      name: 'Test Drink ' + i,
+      detail: 'A made up drink for measuring how fast the catalog syncs',
+      layers: [LAYER.FOAM_TO_TOP, LAYER.MILK_TO_MID, LAYER.ESPRESSO_SHOT]
+    });
+  }
+  return recipes;
+}
+
+/* send the stream a chunk at a time - the first is marked as the start and the last as the end */
+function sendCatalog(bytes, started) {
+  var offset = 0;
+
+  function sendNext() {
+    var message = { 'SYNC_CHUNK': bytes.slice(offset, offset + CHUNK_SIZE) };
+    if (offset === 0) {
+      message.SYNC_BEGIN = 1;
+    }
+    offset += CHUNK_SIZE;
+    if (offset >= bytes.length) {
+      message.SYNC_END = 1;
+    }
+
+    Pebble.sendAppMessage(message, function() {
+      if (offset < bytes.length) {
+        sendNext();
+      } else {
+        var ms = Date.now() - started;
+        console.log('catalog sync: sent ' + bytes.length + ' bytes in ' + ms + ' ms (' +
+            Math.round(bytes.length * 1000 / Math.max(ms, 1)) + ' bytes/s)');
+      }
+    }, function(e) {
+      console.log('catalog sync: failed at byte ' + offset + ' - ' + JSON.stringify(e));
+    });
+  }
+
+  sendNext();
+}
+
+Pebble.addEventListener('ready', function() {
+  if (!FORCE_SYNC && localStorage.getItem('catalogVersion') === String(CATALOG_VERSION)) {
+    return;
+  }
+  var recipes = RECIPES.concat(syntheticRecipes(SYNTHETIC_DRINKS));
+  sendCatalog(encodeRecipes(recipes), Date.now());
+});
+
+/* the watch has the catalog once it says what it stored - until then the next start tries again */
+Pebble.addEventListener('appmessage', function(e) {
+  if (e.payload.SYNC_STORED !== undefined) {
+    console.log('catalog sync: watch stored ' + e.payload.SYNC_STORED + ' drinks');
+    localStorage.setItem('catalogVersion', String(CATALOG_VERSION));
+  }
+});
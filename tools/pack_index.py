@@ -0,0 +1,54 @@
+#!/usr/bin/env python
+#
+# Builds a name index from src/catalog.h into a raw resource, read on the watch by src/name_index.c. The drinks
+# are sorted by name and split into buckets by first letter, so the first drink for a letter is one lookup.
+#
+# Layout (little endian):
+#   uint16 number of drinks
+#   uint16 bucket starts, one per letter A-Z, one for names not starting with a letter, plus one for the end
+#          (positions in the sorted list)
+#   uint16 drink numbers, in name order
+#
+# Usage: pack_index.py src/catalog.h resources/data/name_index.bin
+
+import struct
+import sys
+
+from pack_strings import read_catalog
+
+LETTERS = 26
+BUCKETS = LETTERS + 1
+
+
+def bucket(name):
+    first = name[:1].upper()
+    if first.isalpha():
+        return ord(first) - ord('A')
+    return LETTERS
+
+
+def pack(catalog_path, output_path):
+    names = [header.decode('ascii') for header, detail in read_catalog(catalog_path)]
+    # folded to upper case, as name_index_compare does - folding to lower would put '_' and the like before
+    # letters rather than after them
+    order = sorted(range(len(names)), key=lambda i: (bucket(names[i]), names[i].upper(), i))
+
+    starts = []
+    position = 0
+    for b in range(BUCKETS):
+        starts.append(position)
+        while position < len(order) and bucket(names[order[position]]) == b:
+            position += 1
+    starts.append(len(order))
+
+    packed = bytearray(struct.pack('<H', len(names)))
+    packed.extend(struct.pack('<%dH' % len(starts), *starts))
+    packed.extend(struct.pack('<%dH' % len(order), *order))
+    with open(output_path, 'wb') as f:
+        f.write(packed)
+
+    print('name index: %d drinks, %d bytes' % (len(names), len(packed)))
+
+
+if __name__ == '__main__':
+    pack(sys.argv[1], sys.argv[2])
@@ -0,0 +1,138 @@
+#!/usr/bin/env python
+#
+# Packs the detail text from src/catalog.h into a compressed raw resource, decoded on the watch by
+# src/string_table.c. Text is plain ASCII, so bytes 0x80 and up are free to stand for words from a
+# dictionary - the dictionary is built greedily, taking whichever repeated substring saves most each time.
+#
+# Layout (little endian):
+#   uint8  number of strings
+#   uint8  number of words
+#   uint16 longest decoded string, without the terminator
+#   uint16 word offsets, one per word plus one for the end (from the start of the word data)
+#   uint16 string offsets, one per string plus one for the end (from the start of the string data)
+#   word data, then string data
+#
+# Usage: pack_strings.py src/catalog.h resources/data/detail_text.bin
+
+import re
+import struct
+import sys
+
+MAX_WORDS = 128
+MIN_WORD = 3
+MAX_WORD = 16
+
+
+# the simple escapes C allows in a string literal, and what they stand for
+ESCAPES = {'n': '\n', 't': '\t', 'r': '\r', 'a': '\a', 'b': '\b', 'f': '\f', 'v': '\v',
+           '\\': '\\', '"': '"', "'": "'", '?': '?'}
+
+
+def unescape(literal):
+    # the characters a C string literal's contents stand for - simple, octal and hex escapes
+    def replace(match):
+        escape = match.group(1)
+        if escape[0] == 'x':
+            return chr(int(escape[1:], 16))
+        if escape[0] in '01234567':
+            return chr(int(escape, 8))
+        if escape not in ESCAPES:
+            raise ValueError('unknown escape \\%s in catalog string "%s"' % (escape, literal))
+        return ESCAPES[escape]
+    return re.sub(r'\\(x[0-9a-fA-F]+|[0-7]{1,3}|.)', replace, literal)
+
+
+def read_catalog(catalog_path):
+    # DRINK(id, "header", "detail", paint) - the header & detail are the two string literals in each entry
+    with open(catalog_path) as f:
+        source = f.read().replace('\\\n', ' ')
+    entries = []
+    for entry in re.finditer(r'DRINK\(\s*\w+\s*,\s*"((?:[^"\\]|\\.)*)"\s*,\s*"((?:[^"\\]|\\.)*)"', source):
+        entries.append((unescape(entry.group(1)).encode('ascii'), unescape(entry.group(2)).encode('ascii')))
+    return entries
+
+
+def read_details(catalog_path):
+    return [detail for header, detail in read_catalog(catalog_path)]
+
+
+def literal_runs(encoded):
+    # the stretches of each string not yet replaced by words
+    run = []
+    for symbol in encoded:
+        if symbol < 0x80:
+            run.append(symbol)
+        else:
+            if run:
+                yield run
+            run = []
+    if run:
+        yield run
+
+
+def best_word(strings):
+    counts = {}
+    for encoded in strings:
+        for run in literal_runs(encoded):
+            for length in range(MIN_WORD, MAX_WORD + 1):
+                for start in range(len(run) - length + 1):
+                    word = tuple(run[start:start + length])
+                    counts[word] = counts.get(word, 0) + 1
+    best, best_saving = None, 0
+    for word, count in counts.items():
+        # each use saves len - 1 bytes, and the word costs its bytes plus an offset
+        saving = count * (len(word) - 1) - len(word) - 2
+        if saving > best_saving:
+            best, best_saving = word, saving
+    return best
+
+
+def replace_word(encoded, word, code):
+    out, i = [], 0
+    while i < len(encoded):
+        if tuple(encoded[i:i + len(word)]) == word:
+            out.append(code)
+            i += len(word)
+        else:
+            out.append(encoded[i])
+            i += 1
+    return out
+
+
+def pack(catalog_path, output_path):
+    details = read_details(catalog_path)
+    strings = [list(bytearray(text)) for text in details]
+    words = []
+    while len(words) < MAX_WORDS:
+        word = best_word(strings)
+        if word is None:
+            break
+        strings = [replace_word(encoded, word, 0x80 + len(words)) for encoded in strings]
+        words.append(word)
+
+    word_data = bytearray()
+    word_offsets = [0]
+    for word in words:
+        word_data.extend(word)
+        word_offsets.append(len(word_data))
+    string_data = bytearray()
+    string_offsets = [0]
+    for encoded in strings:
+        string_data.extend(encoded)
+        string_offsets.append(len(string_data))
+
+    longest = max(len(text) for text in details)
+    packed = bytearray(struct.pack('<BBH', len(strings), len(words), longest))
+    packed.extend(struct.pack('<%dH' % len(word_offsets), *word_offsets))
+    packed.extend(struct.pack('<%dH' % len(string_offsets), *string_offsets))
+    packed.extend(word_data)
+    packed.extend(string_data)
+    with open(output_path, 'wb') as f:
+        f.write(packed)
+
+    plain = sum(len(text) + 1 for text in details)
+    print('detail text: %d bytes plain, %d packed (%d words)' % (plain, len(packed), len(words)))
+
+
+if __name__ == '__main__':
+    pack(sys.argv[1], sys.argv[2])